@@ -0,0 +1,535 @@
+#include <MPIEnvironment.h>
+#include <Operations.h>
+#include <RequestSet.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+
+/// OSU-style micro benchmarks, every operation timed through the wrapper and through the
+/// equivalent raw MPI call on the same buffers. Run with e.g.
+///     mpirun -np 4 ./benchMPIWrapper --format json --output results.json
+/// Options: --format csv|json, --output FILE, --min-bytes N, --max-bytes N,
+///          --iterations N (fixed count instead of scaling with the size), --filter SUBSTRING
+
+namespace {
+
+struct Options {
+    std::string format = "csv";
+    std::string output;
+    std::string filter;
+    size_t minBytes = 8;
+    size_t maxBytes = size_t{1} << 20;
+    size_t iterations = 0;
+};
+
+struct Result {
+    std::string benchmark;
+    int ranks;
+    size_t bytes;
+    size_t iterations;
+    double raw;      // microseconds per iteration, slowest rank
+    double wrapper;
+};
+
+Options parse(const int argc, char** argv) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string_view key = argv[i];
+        const char* value = argv[i + 1];
+        if (key == "--format") {
+            options.format = value;
+        } else if (key == "--output") {
+            options.output = value;
+        } else if (key == "--filter") {
+            options.filter = value;
+        } else if (key == "--min-bytes") {
+            options.minBytes = std::max<size_t>(std::strtoull(value, nullptr, 10), sizeof(double));
+        } else if (key == "--max-bytes") {
+            options.maxBytes = std::strtoull(value, nullptr, 10);
+        } else if (key == "--iterations") {
+            options.iterations = std::strtoull(value, nullptr, 10);
+        }
+    }
+    return options;
+}
+
+/// Large messages get fewer repetitions, like the OSU suite
+size_t iterationsFor(const Options& options, const size_t bytes) {
+    if (options.iterations > 0) {
+        return options.iterations;
+    }
+    return std::clamp<size_t>((size_t{1} << 26) / bytes, 10, 1000);
+}
+
+/// Average time per call of body on the slowest rank, in microseconds
+template<typename Body>
+double time(const size_t iterations, Body&& body) {
+    for (size_t i = 0; i < std::max<size_t>(iterations / 10, 1); ++i) {
+        body();
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    const double start = MPI_Wtime();
+    for (size_t i = 0; i < iterations; ++i) {
+        body();
+    }
+    double elapsed = (MPI_Wtime() - start) * 1e6 / static_cast<double>(iterations);
+    MPI_Allreduce(MPI_IN_PLACE, &elapsed, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    return elapsed;
+}
+
+class Suite {
+public:
+
+    Suite(const Options& options, const int ranks) : options_(options), ranks_(ranks) {}
+
+    /// Times raw and wrapper alternately for every message size, elements are doubles
+    template<typename Raw, typename Wrapper>
+    void run(const std::string& benchmark, Raw&& raw, Wrapper&& wrapper) {
+        if (!options_.filter.empty() && benchmark.find(options_.filter) == std::string::npos) {
+            return;
+        }
+        for (size_t bytes = options_.minBytes; bytes <= options_.maxBytes; bytes *= 4) {
+            const size_t count = bytes / sizeof(double);
+            const size_t iterations = iterationsFor(options_, bytes);
+            const double rawTime = time(iterations, [&raw, count] { raw(count); });
+            const double wrapperTime = time(iterations, [&wrapper, count] { wrapper(count); });
+            results_.push_back({benchmark, ranks_, count * sizeof(double), iterations, rawTime, wrapperTime});
+        }
+    }
+
+    void write(std::ostream& out) const {
+        if (options_.format == "json") {
+            out << "[\n";
+            for (size_t i = 0; i < results_.size(); ++i) {
+                const Result& r = results_[i];
+                out << "  {\"benchmark\": \"" << r.benchmark << "\", \"ranks\": " << r.ranks
+                    << ", \"bytes\": " << r.bytes << ", \"iterations\": " << r.iterations
+                    << ", \"raw_us\": " << r.raw << ", \"wrapper_us\": " << r.wrapper
+                    << ", \"overhead_pct\": " << overhead(r) << "}" << (i + 1 < results_.size() ? "," : "") << "\n";
+            }
+            out << "]\n";
+        } else {
+            out << "benchmark,ranks,bytes,iterations,raw_us,wrapper_us,overhead_pct\n";
+            for (const Result& r : results_) {
+                out << r.benchmark << "," << r.ranks << "," << r.bytes << "," << r.iterations << ","
+                    << r.raw << "," << r.wrapper << "," << overhead(r) << "\n";
+            }
+        }
+    }
+
+private:
+
+    static double overhead(const Result& r) {
+        return r.raw > 0 ? (r.wrapper - r.raw) / r.raw * 100.0 : 0.0;
+    }
+
+    const Options& options_;
+
+    int ranks_;
+
+    std::vector<Result> results_;
+
+};
+
+}
+
+int main(int argc, char** argv) {
+    mpi::MPIEnvironment env(argc, argv);
+    const Options options = parse(argc, argv);
+
+    const auto local = env.getLocalProcess().lock();
+    const auto remote = env.getRemoteProcesses().lock();
+    const int rank = local->rank();
+    const int ranks = env.getCommSize();
+    const auto commSize = static_cast<size_t>(ranks);
+    const int root = local->root();
+    MPI_Comm comm = local->comm();
+
+    // Every rank works on the same preallocated buffers, the wrapper sees them through array_views
+    const size_t maxCount = options.maxBytes / sizeof(double);
+    mpi::array<double> src(maxCount * commSize);
+    mpi::array<double> dst(maxCount * commSize);
+    for (size_t i = 0; i < src.size(); ++i) {
+        src[i] = static_cast<double>(i % 97);
+    }
+    const auto view = [](const mpi::array<double>& data, const size_t count) {
+        return mpi::array_view<double>(data.data(), count);
+    };
+
+    Suite suite(options, ranks);
+
+    // Point-to-point between ranks 0 and 1, latency is half a round trip
+    if (ranks >= 2) {
+        const int peer = rank == 0 ? 1 : rank == 1 ? 0 : MPI_PROC_NULL;
+        const mpi::RemoteProcess* partner = nullptr;
+        for (const auto& r : *remote) {
+            if (r.rank() == peer) {
+                partner = &r;
+            }
+        }
+        const bool first = rank == 0;
+
+        suite.run("pingpong_sync", [&](const size_t n) {
+            if (peer == MPI_PROC_NULL) return;
+            if (first) {
+                MPI_Send(src.data(), static_cast<int>(n), MPI_DOUBLE, peer, 0, comm);
+                MPI_Recv(dst.data(), static_cast<int>(n), MPI_DOUBLE, peer, 0, comm, MPI_STATUS_IGNORE);
+            } else {
+                MPI_Recv(dst.data(), static_cast<int>(n), MPI_DOUBLE, peer, 0, comm, MPI_STATUS_IGNORE);
+                MPI_Send(src.data(), static_cast<int>(n), MPI_DOUBLE, peer, 0, comm);
+            }
+        }, [&](const size_t n) {
+            if (!partner) return;
+            if (first) {
+                partner->sync() << view(src, n);
+                partner->sync() >> view(dst, n);
+            } else {
+                partner->sync() >> view(dst, n);
+                partner->sync() << view(src, n);
+            }
+        });
+
+        suite.run("pingpong_async", [&](const size_t n) {
+            if (peer == MPI_PROC_NULL) return;
+            MPI_Request requests[2];
+            MPI_Irecv(dst.data(), static_cast<int>(n), MPI_DOUBLE, peer, 0, comm, &requests[0]);
+            if (first) {
+                MPI_Isend(src.data(), static_cast<int>(n), MPI_DOUBLE, peer, 0, comm, &requests[1]);
+                MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
+            } else {
+                MPI_Wait(&requests[0], MPI_STATUS_IGNORE);
+                MPI_Isend(src.data(), static_cast<int>(n), MPI_DOUBLE, peer, 0, comm, &requests[1]);
+                MPI_Wait(&requests[1], MPI_STATUS_IGNORE);
+            }
+        }, [&](const size_t n) {
+            if (!partner) return;
+            const auto received = partner->async() >> view(dst, n);
+            if (first) {
+                const auto sent = partner->async() << view(src, n);
+                sent();
+                received();
+            } else {
+                received();
+                const auto sent = partner->async() << view(src, n);
+                sent();
+            }
+        });
+
+        suite.run("pingpong_persistent", [&](const size_t n) {
+            if (peer == MPI_PROC_NULL) return;
+            MPI_Request requests[2];
+            MPI_Send_init(src.data(), static_cast<int>(n), MPI_DOUBLE, peer, 0, comm, &requests[0]);
+            MPI_Recv_init(dst.data(), static_cast<int>(n), MPI_DOUBLE, peer, 0, comm, &requests[1]);
+            for (int i = 0; i < 8; ++i) {
+                if (first) {
+                    MPI_Start(&requests[0]);
+                    MPI_Wait(&requests[0], MPI_STATUS_IGNORE);
+                    MPI_Start(&requests[1]);
+                    MPI_Wait(&requests[1], MPI_STATUS_IGNORE);
+                } else {
+                    MPI_Start(&requests[1]);
+                    MPI_Wait(&requests[1], MPI_STATUS_IGNORE);
+                    MPI_Start(&requests[0]);
+                    MPI_Wait(&requests[0], MPI_STATUS_IGNORE);
+                }
+            }
+            MPI_Request_free(&requests[0]);
+            MPI_Request_free(&requests[1]);
+        }, [&](const size_t n) {
+            if (!partner) return;
+            auto send = partner->persistent() << view(src, n);
+            auto recv = partner->persistent() >> view(dst, n);
+            for (int i = 0; i < 8; ++i) {
+                if (first) {
+                    send();
+                    recv();
+                } else {
+                    recv();
+                    send();
+                }
+            }
+        });
+
+        // Streaming bandwidth, a window of sends acknowledged once
+        constexpr int WINDOW = 64;
+        suite.run("bandwidth", [&](const size_t n) {
+            if (peer == MPI_PROC_NULL) return;
+            MPI_Request requests[WINDOW];
+            char ack = 0;
+            for (int i = 0; i < WINDOW; ++i) {
+                if (first) {
+                    MPI_Isend(src.data(), static_cast<int>(n), MPI_DOUBLE, peer, 1, comm, &requests[i]);
+                } else {
+                    MPI_Irecv(dst.data(), static_cast<int>(n), MPI_DOUBLE, peer, 1, comm, &requests[i]);
+                }
+            }
+            MPI_Waitall(WINDOW, requests, MPI_STATUSES_IGNORE);
+            if (first) {
+                MPI_Recv(&ack, 1, MPI_CHAR, peer, 2, comm, MPI_STATUS_IGNORE);
+            } else {
+                MPI_Send(&ack, 1, MPI_CHAR, peer, 2, comm);
+            }
+        }, [&](const size_t n) {
+            if (!partner) return;
+            mpi::RequestSet requests;
+            requests.reserve(WINDOW);
+            char ack = 0;
+            for (int i = 0; i < WINDOW; ++i) {
+                if (first) {
+                    requests += partner->async(1) << view(src, n);
+                } else {
+                    requests += partner->async(1) >> view(dst, n);
+                }
+            }
+            requests.waitAll();
+            if (first) {
+                partner->sync(2) >> ack;
+            } else {
+                partner->sync(2) << ack;
+            }
+        });
+    }
+
+    const auto type = MPI_DOUBLE;
+    const auto count = [](const size_t n) { return static_cast<int>(n); };
+
+    suite.run("scatter", [&](const size_t n) {
+        MPI_Scatter(src.data(), count(n), type, dst.data(), count(n), type, root, comm);
+    }, [&](const size_t n) {
+        const auto chunk = mpi::scatter<double>(local->bind(view(src, n * commSize), n * commSize));
+    });
+
+    suite.run("scatterv", [&](const size_t n) {
+        const mpi::array<int> counts = mpi::balancedCounts(n * commSize, commSize);
+        const mpi::array<int> displs = mpi::displacements(counts);
+        MPI_Scatterv(src.data(), counts.data(), displs.data(), type,
+            dst.data(), counts[static_cast<size_t>(rank)], type, root, comm);
+    }, [&](const size_t n) {
+        const auto chunk = mpi::scatterv<double>(local->bind(view(src, n * commSize), n * commSize));
+    });
+
+    suite.run("broadcast", [&](const size_t n) {
+        MPI_Bcast(dst.data(), count(n), type, root, comm);
+    }, [&](const size_t n) {
+        const auto data = mpi::broadcast<double>(local->bind(view(dst, n), n));
+    });
+
+    suite.run("gather", [&](const size_t n) {
+        MPI_Gather(src.data(), count(n), type, dst.data(), count(n), type, root, comm);
+    }, [&](const size_t n) {
+        const auto data = mpi::gather<double>(local->forward(view(src, n)));
+    });
+
+    suite.run("gatherv", [&](const size_t n) {
+        const int mine = count(n);
+        mpi::array<int> counts(commSize);
+        MPI_Gather(&mine, 1, MPI_INT, counts.data(), 1, MPI_INT, root, comm);
+        const mpi::array<int> displs = mpi::displacements(counts);
+        MPI_Gatherv(src.data(), mine, type, dst.data(), counts.data(), displs.data(), type, root, comm);
+    }, [&](const size_t n) {
+        const auto data = mpi::gatherv<double>(local->forward(view(src, n)));
+    });
+
+    suite.run("gatherInPlace", [&](const size_t n) {
+        if (rank == root) {
+            MPI_Gather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, dst.data(), count(n), type, root, comm);
+        } else {
+            MPI_Gather(dst.data(), count(n), type, nullptr, 0, MPI_DATATYPE_NULL, root, comm);
+        }
+    }, [&](const size_t n) {
+        const auto data = mpi::gatherInPlace<double>(
+            local->forward(view(dst, rank == root ? n * commSize : n)));
+    });
+
+    suite.run("allGather", [&](const size_t n) {
+        MPI_Allgather(src.data(), count(n), type, dst.data(), count(n), type, comm);
+    }, [&](const size_t n) {
+        const auto data = mpi::allGather<double>(local->forward(view(src, n)));
+    });
+
+    suite.run("allGatherv", [&](const size_t n) {
+        const int mine = count(n);
+        mpi::array<int> counts(commSize);
+        MPI_Allgather(&mine, 1, MPI_INT, counts.data(), 1, MPI_INT, comm);
+        const mpi::array<int> displs = mpi::displacements(counts);
+        MPI_Allgatherv(src.data(), mine, type, dst.data(), counts.data(), displs.data(), type, comm);
+    }, [&](const size_t n) {
+        const auto data = mpi::allGatherv<double>(local->forward(view(src, n)));
+    });
+
+    suite.run("allGatherInPlace", [&](const size_t n) {
+        MPI_Allgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, dst.data(), count(n), type, comm);
+    }, [&](const size_t n) {
+        const auto data = mpi::allGatherInPlace<double>(local->forward(view(dst, n * commSize)));
+    });
+
+    suite.run("allToAll", [&](const size_t n) {
+        MPI_Alltoall(src.data(), count(n), type, dst.data(), count(n), type, comm);
+    }, [&](const size_t n) {
+        const auto data = mpi::allToAll<double>(local->forward(view(src, n)));
+    });
+
+    suite.run("allToAllv", [&](const size_t n) {
+        const mpi::array<int> sendCounts = mpi::balancedCounts(n * commSize, commSize);
+        const mpi::array<int> sendDispls = mpi::displacements(sendCounts);
+        mpi::array<int> recvCounts(commSize);
+        MPI_Alltoall(sendCounts.data(), 1, MPI_INT, recvCounts.data(), 1, MPI_INT, comm);
+        const mpi::array<int> recvDispls = mpi::displacements(recvCounts);
+        MPI_Alltoallv(src.data(), sendCounts.data(), sendDispls.data(), type,
+            dst.data(), recvCounts.data(), recvDispls.data(), type, comm);
+    }, [&](const size_t n) {
+        const auto data = mpi::allToAllv<double>(local->forward(view(src, n * commSize)));
+    });
+
+    suite.run("reduce", [&](const size_t n) {
+        MPI_Reduce(src.data(), dst.data(), count(n), type, MPI_SUM, root, comm);
+    }, [&](const size_t n) {
+        const auto data = mpi::reduce<double>(*local + view(src, n));
+    });
+
+    suite.run("reduceInPlace", [&](const size_t n) {
+        if (rank == root) {
+            MPI_Reduce(MPI_IN_PLACE, dst.data(), count(n), type, MPI_SUM, root, comm);
+        } else {
+            MPI_Reduce(dst.data(), nullptr, count(n), type, MPI_SUM, root, comm);
+        }
+    }, [&](const size_t n) {
+        const auto data = mpi::reduceInPlace<double>(*local + view(dst, n));
+    });
+
+    suite.run("allReduce", [&](const size_t n) {
+        MPI_Allreduce(src.data(), dst.data(), count(n), type, MPI_SUM, comm);
+    }, [&](const size_t n) {
+        const auto data = mpi::allReduce<double>(*local + view(src, n));
+    });
+
+    suite.run("allReduceInPlace", [&](const size_t n) {
+        MPI_Allreduce(MPI_IN_PLACE, dst.data(), count(n), type, MPI_SUM, comm);
+    }, [&](const size_t n) {
+        const auto data = mpi::allReduceInPlace<double>(*local + view(dst, n));
+    });
+
+    suite.run("scan", [&](const size_t n) {
+        MPI_Scan(src.data(), dst.data(), count(n), type, MPI_SUM, comm);
+    }, [&](const size_t n) {
+        const auto data = mpi::scan<double>(*local + view(src, n));
+    });
+
+    suite.run("scanInPlace", [&](const size_t n) {
+        MPI_Scan(MPI_IN_PLACE, dst.data(), count(n), type, MPI_SUM, comm);
+    }, [&](const size_t n) {
+        const auto data = mpi::scanInPlace<double>(*local + view(dst, n));
+    });
+
+    suite.run("reduceScatter", [&](const size_t n) {
+        const mpi::array<int> counts = mpi::balancedCounts(n * commSize, commSize);
+        MPI_Reduce_scatter(src.data(), dst.data(), counts.data(), type, MPI_SUM, comm);
+    }, [&](const size_t n) {
+        const auto data = mpi::reduceScatter<double>(*local + view(src, n * commSize));
+    });
+
+    // Non-blocking variants, posted and waited for immediately to expose the handle overhead
+    suite.run("iscatter", [&](const size_t n) {
+        MPI_Request request;
+        MPI_Iscatter(src.data(), count(n), type, dst.data(), count(n), type, root, comm, &request);
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+    }, [&](const size_t n) {
+        const auto data = mpi::iscatter<double>(local->bind(view(src, n * commSize), n * commSize))();
+    });
+
+    suite.run("ibroadcast", [&](const size_t n) {
+        MPI_Request request;
+        MPI_Ibcast(dst.data(), count(n), type, root, comm, &request);
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+    }, [&](const size_t n) {
+        const auto data = mpi::ibroadcast<double>(local->bind(view(dst, n), n))();
+    });
+
+    suite.run("igather", [&](const size_t n) {
+        MPI_Request request;
+        MPI_Igather(src.data(), count(n), type, dst.data(), count(n), type, root, comm, &request);
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+    }, [&](const size_t n) {
+        const auto data = mpi::igather<double>(local->forward(view(src, n)))();
+    });
+
+    suite.run("iallGather", [&](const size_t n) {
+        MPI_Request request;
+        MPI_Iallgather(src.data(), count(n), type, dst.data(), count(n), type, comm, &request);
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+    }, [&](const size_t n) {
+        const auto data = mpi::iallGather<double>(local->forward(view(src, n)))();
+    });
+
+    suite.run("iallToAll", [&](const size_t n) {
+        MPI_Request request;
+        MPI_Ialltoall(src.data(), count(n), type, dst.data(), count(n), type, comm, &request);
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+    }, [&](const size_t n) {
+        const auto data = mpi::iallToAll<double>(local->forward(view(src, n)))();
+    });
+
+    suite.run("ireduce", [&](const size_t n) {
+        MPI_Request request;
+        MPI_Ireduce(src.data(), dst.data(), count(n), type, MPI_SUM, root, comm, &request);
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+    }, [&](const size_t n) {
+        const auto data = mpi::ireduce<double>(*local + view(src, n))();
+    });
+
+    suite.run("iallReduce", [&](const size_t n) {
+        MPI_Request request;
+        MPI_Iallreduce(src.data(), dst.data(), count(n), type, MPI_SUM, comm, &request);
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+    }, [&](const size_t n) {
+        const auto data = mpi::iallReduce<double>(*local + view(src, n))();
+    });
+
+    suite.run("iscan", [&](const size_t n) {
+        MPI_Request request;
+        MPI_Iscan(src.data(), dst.data(), count(n), type, MPI_SUM, comm, &request);
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+    }, [&](const size_t n) {
+        const auto data = mpi::iscan<double>(*local + view(src, n))();
+    });
+
+    suite.run("ireduceScatter", [&](const size_t n) {
+        const mpi::array<int> counts = mpi::balancedCounts(n * commSize, commSize);
+        MPI_Request request;
+        MPI_Ireduce_scatter(src.data(), dst.data(), counts.data(), type, MPI_SUM, comm, &request);
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+    }, [&](const size_t n) {
+        const auto data = mpi::ireduceScatter<double>(*local + view(src, n * commSize))();
+    });
+
+    // Persistent plan against re-issuing the raw call, 8 rounds per setup
+    suite.run("allReducePlan", [&](const size_t n) {
+        for (int i = 0; i < 8; ++i) {
+            MPI_Request request;
+            MPI_Iallreduce(src.data(), dst.data(), count(n), type, MPI_SUM, comm, &request);
+            MPI_Wait(&request, MPI_STATUS_IGNORE);
+        }
+    }, [&](const size_t n) {
+        auto plan = mpi::allReducePlan<double>(*local + view(src, n));
+        for (int i = 0; i < 8; ++i) {
+            plan();
+        }
+    });
+
+    if (rank == root) {
+        if (options.output.empty()) {
+            suite.write(std::cout);
+        } else {
+            std::ofstream out(options.output);
+            suite.write(out);
+        }
+    }
+    return 0;
+}
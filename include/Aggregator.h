@@ -0,0 +1,184 @@
+#ifndef AGGREGATOR_H
+#define AGGREGATOR_H
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <mpi.h>
+#include <Message.h>
+#include <RemoteProcess.h>
+#include <array.h>
+#include <array_view.h>
+#include <large_count.h>
+
+
+
+namespace mpi {
+
+/// Packs many small sends to one RemoteProcess into a single message. Values are appended to a
+/// buffer that is sent once it reaches capacity bytes, on flush() and on destruction, so the
+/// per-message latency is paid once per buffer. The matching Disaggregator unpacks them in order.
+/// Values are copied bytewise, hence T must be trivially copyable.
+class Aggregator {
+public:
+
+    /// tag must differ from the tags of every other transfer to remote on its communicator,
+    /// including the default 0 of sync() and async(), or those messages are taken for batches
+    Aggregator(const RemoteProcess& remote, const int tag, const size_t capacity = size_t{1} << 16)
+        : rank_(remote.rank()), comm_(remote.comm()), tag_(tag), capacity_(capacity) {
+        filling_.reserve(capacity_);
+        sending_.reserve(capacity_);
+    }
+
+    Aggregator(const Aggregator& other) = delete;
+
+    Aggregator& operator=(const Aggregator& other) = delete;
+
+    ~Aggregator() {
+        flush();
+        wait();
+    }
+
+    template<typename T>
+    Aggregator& operator<<(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Aggregator: T must be trivially copyable");
+        append(&value, sizeof(T));
+        return *this;
+    }
+
+    /// Packs the size followed by the elements, unpacked into an array of that size
+    template<typename T, typename A>
+    Aggregator& operator<<(const array<T, A>& data) {
+        static_assert(std::is_trivially_copyable_v<T>, "Aggregator: T must be trivially copyable");
+        const size_t size = data.size();
+        append(&size, sizeof(size));
+        append(data.data(), size * sizeof(T));
+        return *this;
+    }
+
+    template<typename T>
+    Aggregator& operator<<(const array_view<T>& data) {
+        return *this << static_cast<const array<T>&>(data);
+    }
+
+    /// Sends what is buffered as one message. The send overlaps with filling the next buffer
+    /// and is only waited for by the next flush.
+    void flush() {
+        if (filling_.empty()) {
+            return;
+        }
+        wait();
+        std::swap(filling_, sending_);
+        filling_.clear();
+        large::isend(sending_.data(), sending_.size(), MPI_BYTE, rank_, tag_, comm_, &request_);
+        ++messages_;
+    }
+
+    /// Bytes buffered and not sent yet
+    [[nodiscard]] size_t size() const { return filling_.size(); }
+
+    /// Messages sent so far
+    [[nodiscard]] size_t messages() const { return messages_; }
+
+private:
+
+    void append(const void* data, const size_t bytes) {
+        if (bytes == 0) {
+            return;
+        }
+        const size_t offset = filling_.size();
+        filling_.resize(offset + bytes);
+        std::memcpy(filling_.data() + offset, data, bytes);
+        if (filling_.size() >= capacity_) {
+            flush();
+        }
+    }
+
+    void wait() {
+        MPI_Wait(&request_, MPI_STATUS_IGNORE);
+    }
+
+    int rank_;
+
+    MPI_Comm comm_;
+
+    int tag_;
+
+    size_t capacity_;
+
+    size_t messages_ = 0;
+
+    std::vector<std::byte> filling_;
+
+    std::vector<std::byte> sending_;
+
+    MPI_Request request_ = MPI_REQUEST_NULL;
+
+};
+
+/// Receiving side of an Aggregator, values must be extracted with the types they were packed
+/// with. The next aggregated message is received whenever the current one is used up.
+class Disaggregator {
+public:
+
+    /// tag is the one the sending Aggregator was created with
+    Disaggregator(const RemoteProcess& remote, const int tag)
+        : rank_(remote.rank()), comm_(remote.comm()), tag_(tag) {}
+
+    template<typename T>
+    Disaggregator& operator>>(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Disaggregator: T must be trivially copyable");
+        extract(&value, sizeof(T));
+        return *this;
+    }
+
+    template<typename T, typename A>
+    Disaggregator& operator>>(array<T, A>& data) {
+        static_assert(std::is_trivially_copyable_v<T>, "Disaggregator: T must be trivially copyable");
+        size_t size;
+        extract(&size, sizeof(size));
+        if (data.size() != size) {
+            data = array<T, A>(size);
+        }
+        extract(data.data(), size * sizeof(T));
+        return *this;
+    }
+
+    /// Returns true when the current message is used up, without receiving
+    [[nodiscard]] bool empty() const { return offset_ == buffer_.size(); }
+
+private:
+
+    void extract(void* data, const size_t bytes) {
+        if (bytes == 0) {
+            return;
+        }
+        if (empty()) {
+            buffer_ = receive<std::byte>(rank_, tag_, comm_).data;
+            offset_ = 0;
+        }
+        if (offset_ + bytes > buffer_.size()) {
+            throw std::length_error("Disaggregator: value spans past the aggregated message");
+        }
+        std::memcpy(data, buffer_.data() + offset_, bytes);
+        offset_ += bytes;
+    }
+
+    int rank_;
+
+    MPI_Comm comm_;
+
+    int tag_;
+
+    array<std::byte> buffer_;
+
+    size_t offset_ = 0;
+
+};
+
+}
+
+#endif //AGGREGATOR_H
@@ -0,0 +1,66 @@
+#ifndef CARTESIAN_H
+#define CARTESIAN_H
+
+#include <memory>
+#include <utility>
+#include <vector>
+#include <mpi.h>
+#include <Communicator.h>
+
+
+
+namespace mpi {
+
+/// Ranks of a communicator arranged as an N-dimensional grid (MPI_Cart_create). Dimensions
+/// passed as 0 are chosen by MPI_Dims_create. With reorder, MPI may renumber the ranks to match
+/// the machine, so use rank() of this topology rather than of the parent. Collective.
+class Cartesian {
+public:
+
+    Cartesian(const Communicator& parent, std::vector<int> dims, const std::vector<bool>& periods,
+              bool reorder = true);
+
+    /// Periodic in no dimension
+    Cartesian(const Communicator& parent, std::vector<int> dims);
+
+    /// The grid communicator, e.g. for LocalProcess or the collectives
+    [[nodiscard]] std::shared_ptr<Communicator> communicator() const;
+
+    [[nodiscard]] MPI_Comm get() const;
+
+    [[nodiscard]] int rank() const;
+
+    [[nodiscard]] int size() const;
+
+    [[nodiscard]] int ndims() const;
+
+    [[nodiscard]] const std::vector<int>& dims() const;
+
+    [[nodiscard]] const std::vector<bool>& periods() const;
+
+    /// Grid coordinates of this rank
+    [[nodiscard]] const std::vector<int>& coords() const;
+
+    [[nodiscard]] std::vector<int> coords(int rank) const;
+
+    /// Rank at coords, wrapped in periodic dimensions, MPI_PROC_NULL when off the grid
+    [[nodiscard]] int rankAt(std::vector<int> coords) const;
+
+    /// (source, destination) of a shift by disp along dim, MPI_PROC_NULL past a non-periodic edge
+    [[nodiscard]] std::pair<int, int> shift(int dim, int disp = 1) const;
+
+private:
+
+    std::shared_ptr<Communicator> comm_;
+
+    std::vector<int> dims_;
+
+    std::vector<bool> periods_;
+
+    std::vector<int> coords_;
+
+};
+
+}
+
+#endif //CARTESIAN_H
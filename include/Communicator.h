@@ -0,0 +1,69 @@
+#ifndef COMMUNICATOR_H
+#define COMMUNICATOR_H
+
+#include <memory>
+#include <mpi.h>
+
+
+
+namespace mpi {
+
+/// RAII wrapper of an MPI communicator together with its root rank. Processes and operations
+/// share it through std::shared_ptr, communicators created by split()/dup() are freed with the
+/// last owner.
+class Communicator {
+public:
+
+    /// Wraps comm, owned communicators are released with MPI_Comm_free
+    explicit Communicator(MPI_Comm comm, bool owned);
+
+    Communicator(const Communicator& other) = delete;
+
+    Communicator& operator=(const Communicator& other) = delete;
+
+    ~Communicator();
+
+    /// MPI_COMM_WORLD, never freed
+    [[nodiscard]] static std::shared_ptr<Communicator> world();
+
+    /// Ranks passing the same color end up in the same communicator, ordered by key.
+    /// Returns nullptr on ranks passing MPI_UNDEFINED.
+    [[nodiscard]] std::shared_ptr<Communicator> split(int color, int key = 0) const;
+
+    [[nodiscard]] std::shared_ptr<Communicator> dup() const;
+
+    /// Ranks sharing memory with this one (i.e. the same node), via MPI_COMM_TYPE_SHARED
+    [[nodiscard]] std::shared_ptr<Communicator> splitShared() const;
+
+    /// Number of ranks on this node. Collective on the first call, the result is cached.
+    [[nodiscard]] int nodeSize() const;
+
+    [[nodiscard]] MPI_Comm get() const;
+
+    [[nodiscard]] int rank() const;
+
+    [[nodiscard]] int size() const;
+
+    [[nodiscard]] int root() const;
+
+    void setRoot(int root);
+
+private:
+
+    MPI_Comm comm_;
+
+    bool owned_;
+
+    int rank_;
+
+    int size_;
+
+    int root_ = 0;
+
+    mutable int nodeSize_ = 0;
+
+};
+
+}
+
+#endif //COMMUNICATOR_H
@@ -0,0 +1,336 @@
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include <algorithm>
+#include <coroutine>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <mpi.h>
+#include <Future.h>
+#include <RemoteProcess.h>
+
+
+
+namespace mpi {
+
+class Scheduler;
+
+/// Coroutine driven by a Scheduler. Inside a Task, co_await suspends on an Awaitable, a Future
+/// or another Task without blocking the rank. Tasks start lazily, either through
+/// Scheduler::spawn() or when first awaited.
+class Task {
+public:
+
+    class promise_type {
+    public:
+
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        /// Resumes the awaiting Task, if any, without growing the stack
+        auto final_suspend() noexcept {
+            struct FinalAwaiter {
+                bool await_ready() noexcept { return false; }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                    const auto continuation = handle.promise().continuation_;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+
+                void await_resume() noexcept {}
+            };
+            return FinalAwaiter{};
+        }
+
+        void return_void() {}
+
+        void unhandled_exception() {
+            exception_ = std::current_exception();
+        }
+
+        [[nodiscard]] Scheduler& scheduler() const { return *scheduler_; }
+
+    private:
+
+        friend class Task;
+
+        friend class Scheduler;
+
+        Scheduler* scheduler_ = nullptr;
+
+        std::coroutine_handle<> continuation_;
+
+        std::exception_ptr exception_;
+
+    };
+
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    Task(const Task& other) = delete;
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    Task& operator=(const Task& other) = delete;
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    [[nodiscard]] bool done() const { return !handle_ || handle_.done(); }
+
+    /// Runs the Task to completion before the awaiting one continues
+    auto operator co_await() && noexcept {
+        struct TaskAwaiter {
+            handle_type handle_;
+
+            bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+
+            std::coroutine_handle<> await_suspend(handle_type parent) const noexcept {
+                handle_.promise().scheduler_ = parent.promise().scheduler_;
+                handle_.promise().continuation_ = parent;
+                return handle_;
+            }
+
+            void await_resume() const {
+                if (handle_ && handle_.promise().exception_) {
+                    std::rethrow_exception(handle_.promise().exception_);
+                }
+            }
+        };
+        return TaskAwaiter{handle_};
+    }
+
+private:
+
+    friend class Scheduler;
+
+    explicit Task(handle_type handle) : handle_(handle) {}
+
+    handle_type handle_;
+
+};
+
+/// Single-threaded event loop. Every request a Task suspends on is kept in one contiguous array
+/// polled with MPI_Testsome, and the Tasks whose requests completed are resumed, so independent
+/// exchanges interleave on one rank. Non-blocking collectives must still be issued in the same
+/// order on every rank, i.e. not after a suspension point whose completion order may differ.
+class Scheduler {
+public:
+
+    Scheduler() = default;
+
+    Scheduler(const Scheduler& other) = delete;
+
+    Scheduler& operator=(const Scheduler& other) = delete;
+
+    /// Queues task, it first runs on the next poll()
+    void spawn(Task&& task) {
+        task.handle_.promise().scheduler_ = this;
+        ready_.push_back(task.handle_);
+        tasks_.push_back(std::move(task));
+    }
+
+    /// Polls until every spawned Task has finished, rethrowing the first exception
+    void run() {
+        while (poll()) {
+            if (ready_.empty() && requests_.empty()) {
+                throw std::logic_error("Scheduler::run: tasks suspended on nothing the scheduler polls");
+            }
+        }
+    }
+
+    /// Resumes whatever is ready once and returns whether Tasks are still unfinished
+    bool poll() {
+        if (!requests_.empty()) {
+            indices_.resize(requests_.size());
+            int count = 0;
+            MPI_Testsome(static_cast<int>(requests_.size()), requests_.data(), &count, indices_.data(),
+                         MPI_STATUSES_IGNORE);
+            if (count != MPI_UNDEFINED && count > 0) {
+                for (int i = 0; i < count; ++i) {
+                    const Waiter& waiter = waiters_[static_cast<size_t>(indices_[static_cast<size_t>(i)])];
+                    *waiter.request = MPI_REQUEST_NULL;
+                    ready_.push_back(waiter.handle);
+                }
+                compact();
+            }
+        }
+
+        resuming_.swap(ready_);
+        for (const auto handle : resuming_) {
+            handle.resume();
+        }
+        resuming_.clear();
+
+        return reap();
+    }
+
+    /// Parks handle until request completes. request must stay valid while suspended.
+    void suspend(MPI_Request* request, std::coroutine_handle<> handle) {
+        requests_.push_back(*request);
+        waiters_.push_back({request, handle});
+    }
+
+    /// Number of requests Tasks are currently suspended on
+    [[nodiscard]] size_t pending() const { return requests_.size(); }
+
+    /// Number of spawned Tasks not finished yet
+    [[nodiscard]] size_t size() const { return tasks_.size(); }
+
+private:
+
+    struct Waiter {
+        MPI_Request* request;
+
+        std::coroutine_handle<> handle;
+    };
+
+    /// Drops the entries MPI_Testsome completed, keeping the order of the others
+    void compact() {
+        size_t kept = 0;
+        for (size_t i = 0; i < requests_.size(); ++i) {
+            if (requests_[i] != MPI_REQUEST_NULL) {
+                requests_[kept] = requests_[i];
+                waiters_[kept] = waiters_[i];
+                ++kept;
+            }
+        }
+        requests_.resize(kept);
+        waiters_.resize(kept);
+    }
+
+    bool reap() {
+        std::exception_ptr exception;
+        std::erase_if(tasks_, [&exception](const Task& task) {
+            if (!task.done()) {
+                return false;
+            }
+            if (!exception && task.handle_.promise().exception_) {
+                exception = task.handle_.promise().exception_;
+            }
+            return true;
+        });
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+        return !tasks_.empty();
+    }
+
+    std::vector<Task> tasks_;
+
+    std::vector<MPI_Request> requests_;
+
+    std::vector<Waiter> waiters_;
+
+    std::vector<int> indices_;
+
+    std::vector<std::coroutine_handle<>> ready_;
+
+    std::vector<std::coroutine_handle<>> resuming_;
+
+};
+
+/// Suspends the awaiting Task on an MPI_Request owned elsewhere
+class RequestAwaiter {
+public:
+
+    explicit RequestAwaiter(MPI_Request* request) : request_(request) {}
+
+    [[nodiscard]] bool await_ready() const {
+        int flag = 0;
+        MPI_Test(request_, &flag, MPI_STATUS_IGNORE);
+        return flag != 0;
+    }
+
+    void await_suspend(Task::handle_type handle) const {
+        handle.promise().scheduler().suspend(request_, handle);
+    }
+
+    void await_resume() const noexcept {}
+
+private:
+
+    MPI_Request* request_;
+
+};
+
+/// Takes over the request of a point-to-point or one-sided operation, e.g.
+///     co_await (remote.async() << data);
+class AwaitableAwaiter {
+public:
+
+    explicit AwaitableAwaiter(RemoteProcess::Awaitable&& awaitable) : request_(awaitable.release()) {}
+
+    AwaitableAwaiter(const AwaitableAwaiter& other) = delete;
+
+    AwaitableAwaiter& operator=(const AwaitableAwaiter& other) = delete;
+
+    [[nodiscard]] bool await_ready() { return RequestAwaiter(&request_).await_ready(); }
+
+    void await_suspend(Task::handle_type handle) { RequestAwaiter(&request_).await_suspend(handle); }
+
+    void await_resume() const noexcept {}
+
+private:
+
+    MPI_Request request_;
+
+};
+
+/// Resumes with the result of a non-blocking collective. F is a Future or a reference to one.
+template<typename F>
+class FutureAwaiter {
+public:
+
+    explicit FutureAwaiter(F&& future) : future_(std::forward<F>(future)) {}
+
+    FutureAwaiter(const FutureAwaiter& other) = delete;
+
+    FutureAwaiter& operator=(const FutureAwaiter& other) = delete;
+
+    [[nodiscard]] bool await_ready() const { return future_.test(); }
+
+    void await_suspend(Task::handle_type handle) { RequestAwaiter(future_.request()).await_suspend(handle); }
+
+    auto await_resume() { return future_(); }
+
+private:
+
+    F future_;
+
+};
+
+inline AwaitableAwaiter operator co_await(RemoteProcess::Awaitable&& awaitable) {
+    return AwaitableAwaiter(std::move(awaitable));
+}
+
+template<typename T, typename A>
+FutureAwaiter<Future<T, A>> operator co_await(Future<T, A>&& future) {
+    return FutureAwaiter<Future<T, A>>(std::move(future));
+}
+
+template<typename T, typename A>
+FutureAwaiter<Future<T, A>&> operator co_await(Future<T, A>& future) {
+    return FutureAwaiter<Future<T, A>&>(future);
+}
+
+}
+
+#endif //COROUTINE_H
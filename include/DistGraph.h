@@ -0,0 +1,58 @@
+#ifndef DIST_GRAPH_H
+#define DIST_GRAPH_H
+
+#include <memory>
+#include <vector>
+#include <mpi.h>
+#include <Communicator.h>
+
+
+
+namespace mpi {
+
+/// Sparse communication graph over the ranks of a communicator (MPI_Dist_graph_create_adjacent).
+/// Every rank names the ranks it receives from (sources) and sends to (destinations), optionally
+/// weighted by traffic. With reorder the library may renumber the ranks to match the machine,
+/// neighbours are then reported in the new numbering. Run the neighbour collectives of
+/// Operations.h on a LocalProcess of communicator(). Collective.
+class DistGraph {
+public:
+
+    DistGraph(const Communicator& parent, const std::vector<int>& sources, const std::vector<int>& destinations,
+              const std::vector<int>& sourceWeights = {}, const std::vector<int>& destinationWeights = {},
+              bool reorder = true);
+
+    /// Symmetric graph exchanging with neighbors in both directions
+    DistGraph(const Communicator& parent, const std::vector<int>& neighbors, bool reorder = true);
+
+    [[nodiscard]] std::shared_ptr<Communicator> communicator() const;
+
+    [[nodiscard]] MPI_Comm get() const;
+
+    [[nodiscard]] int rank() const;
+
+    [[nodiscard]] int size() const;
+
+    /// Ranks this one receives from, in the order neighbour collectives deliver them
+    [[nodiscard]] const std::vector<int>& sources() const;
+
+    /// Ranks this one sends to, in the order neighbour collectives expect the blocks
+    [[nodiscard]] const std::vector<int>& destinations() const;
+
+    [[nodiscard]] int indegree() const;
+
+    [[nodiscard]] int outdegree() const;
+
+private:
+
+    std::shared_ptr<Communicator> comm_;
+
+    std::vector<int> sources_;
+
+    std::vector<int> destinations_;
+
+};
+
+}
+
+#endif //DIST_GRAPH_H
@@ -0,0 +1,278 @@
+#ifndef DISTRIBUTED_ARRAY_H
+#define DISTRIBUTED_ARRAY_H
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <mpi.h>
+#include <LocalProcess.h>
+#include <Operations.h>
+#include <array.h>
+#include <array_view.h>
+#include <mpi_types.h>
+
+
+
+namespace mpi {
+
+/// Maps the global indices [0, size) of a distributed array to ranks and local indices.
+/// block() gives every rank one contiguous run sized as balancedCounts(), blockCyclic() deals
+/// out blocks of blockSize round robin. Local indices grow with the global index on every rank.
+class Layout {
+public:
+
+    [[nodiscard]] static Layout block(const size_t size, const int commSize) {
+        return Layout(size, static_cast<size_t>(commSize), 0);
+    }
+
+    [[nodiscard]] static Layout blockCyclic(const size_t size, const int commSize, const size_t blockSize) {
+        if (blockSize == 0) {
+            throw std::invalid_argument("Layout::blockCyclic: block size must be positive");
+        }
+        return Layout(size, static_cast<size_t>(commSize), blockSize);
+    }
+
+    /// Rank holding global index
+    [[nodiscard]] int owner(const size_t global) const {
+        if (cyclic()) {
+            return static_cast<int>(global / blockSize_ % commSize_);
+        }
+        const size_t quotient = size_ / commSize_;
+        const size_t remainder = size_ % commSize_;
+        const size_t large = remainder * (quotient + 1);
+        return static_cast<int>(global < large ? global / (quotient + 1) : remainder + (global - large) / quotient);
+    }
+
+    /// Position of global index within its owner's block
+    [[nodiscard]] size_t local(const size_t global) const {
+        if (cyclic()) {
+            return global / blockSize_ / commSize_ * blockSize_ + global % blockSize_;
+        }
+        return global - start(static_cast<size_t>(owner(global)));
+    }
+
+    /// Global index of the local-th element of rank
+    [[nodiscard]] size_t global(const int rank, const size_t local) const {
+        if (cyclic()) {
+            return (local / blockSize_ * commSize_ + static_cast<size_t>(rank)) * blockSize_ + local % blockSize_;
+        }
+        return start(static_cast<size_t>(rank)) + local;
+    }
+
+    /// Number of elements rank holds
+    [[nodiscard]] size_t localSize(const int rank) const {
+        const auto r = static_cast<size_t>(rank);
+        if (!cyclic()) {
+            return start(r + 1) - start(r);
+        }
+        const size_t blocks = (size_ + blockSize_ - 1) / blockSize_;
+        const size_t owned = blocks / commSize_ + (r < blocks % commSize_ ? 1 : 0);
+        // Only the last block may be short
+        const bool ownsLast = blocks > 0 && (blocks - 1) % commSize_ == r;
+        return owned * blockSize_ - (ownsLast ? blocks * blockSize_ - size_ : 0);
+    }
+
+    [[nodiscard]] size_t size() const { return size_; }
+
+    [[nodiscard]] size_t commSize() const { return commSize_; }
+
+    /// 0 for block()
+    [[nodiscard]] size_t blockSize() const { return blockSize_; }
+
+    [[nodiscard]] bool cyclic() const { return blockSize_ != 0; }
+
+    bool operator==(const Layout& other) const = default;
+
+private:
+
+    Layout(const size_t size, const size_t commSize, const size_t blockSize)
+        : size_(size), commSize_(commSize), blockSize_(blockSize) {}
+
+    [[nodiscard]] size_t start(const size_t rank) const {
+        return rank * (size_ / commSize_) + std::min(rank, size_ % commSize_);
+    }
+
+    size_t size_;
+
+    size_t commSize_;
+
+    size_t blockSize_;
+
+};
+
+/// Array of layout.size() elements partitioned over the ranks of a LocalProcess, every rank
+/// owning its block as an mpi::array. Work is owner-computes: for_each()/transform() only touch
+/// the local block, reduce() folds locally and combines the partial results collectively.
+template<typename T, typename A = new_allocator<T>>
+class DistributedArray {
+public:
+
+    using value_type = T;
+
+    /// Allocates the local block of layout filled with value, without communicating
+    DistributedArray(std::shared_ptr<const LocalProcess> local, const Layout& layout, const T& value = T())
+        : local_(std::move(local)), layout_(layout), data_(layout_.localSize(local_->rank())) {
+        checkLayout();
+        std::fill(data_.begin(), data_.end(), value);
+    }
+
+    /// Block layout of size elements
+    DistributedArray(std::shared_ptr<const LocalProcess> local, const size_t size, const T& value = T())
+        : DistributedArray(local, Layout::block(size, local->commSize()), value) {}
+
+    /// Adopts block as this rank's part of layout
+    DistributedArray(std::shared_ptr<const LocalProcess> local, const Layout& layout, array<T, A>&& block)
+        : local_(std::move(local)), layout_(layout), data_(std::move(block)) {
+        checkLayout();
+        if (data_.size() != layout_.localSize(local_->rank())) {
+            throw std::invalid_argument("DistributedArray: block size does not match the layout");
+        }
+    }
+
+    /// Runs f(value) or f(globalIndex, value) on every local element
+    template<typename Func>
+    void for_each(Func&& f) {
+        for (size_t i = 0; i < data_.size(); ++i) {
+            if constexpr (std::is_invocable_v<Func&, size_t, T&>) {
+                f(globalIndex(i), data_[i]);
+            } else {
+                f(data_[i]);
+            }
+        }
+    }
+
+    /// Array of the same layout holding f(value) or f(globalIndex, value)
+    template<typename Func>
+    [[nodiscard]] auto transform(Func&& f) const {
+        using U = std::remove_cvref_t<typename std::conditional_t<std::is_invocable_v<Func&, size_t, const T&>,
+            std::invoke_result<Func&, size_t, const T&>, std::invoke_result<Func&, const T&>>::type>;
+        array<U> out(data_.size());
+        for (size_t i = 0; i < data_.size(); ++i) {
+            if constexpr (std::is_invocable_v<Func&, size_t, const T&>) {
+                out[i] = f(globalIndex(i), data_[i]);
+            } else {
+                out[i] = f(data_[i]);
+            }
+        }
+        return DistributedArray<U>(local_, layout_, std::move(out));
+    }
+
+    /// Folds all elements into init with op. Every rank folds its block, the partial results
+    /// are allGathered and folded in rank order, so every rank returns the same value. op must be
+    /// associative, and commutative too for block-cyclic layouts. Collective.
+    template<typename Op = std::plus<T>>
+    [[nodiscard]] T reduce(T init = T(), Op op = Op()) const {
+        static_assert(is_mpi_type<T>::value || std::is_trivially_copyable_v<T>,
+            "DistributedArray::reduce: T is sent as bytes and must be trivially copyable");
+        array<T> partial(data_.empty() ? 0 : 1);
+        if (!data_.empty()) {
+            T acc = data_[0];
+            for (size_t i = 1; i < data_.size(); ++i) {
+                acc = op(std::move(acc), data_[i]);
+            }
+            partial[0] = std::move(acc);
+        }
+        const array<T> partials = allGatherv<T>(local_->forward(std::move(partial)));
+        for (const auto& value : partials) {
+            init = op(std::move(init), value);
+        }
+        return init;
+    }
+
+    /// Same elements laid out as target. Every rank sends each element straight to its new
+    /// owner with one allToAllv, receivers place them by recomputing the old owners. Collective.
+    [[nodiscard]] DistributedArray redistribute(const Layout& target) const {
+        static_assert(is_mpi_type<T>::value || std::is_trivially_copyable_v<T>,
+            "DistributedArray::redistribute: T is sent as bytes and must be trivially copyable");
+        if (target.size() != layout_.size()) {
+            throw std::invalid_argument("DistributedArray::redistribute: sizes differ");
+        }
+        const auto commSize = static_cast<size_t>(local_->commSize());
+        const int rank = local_->rank();
+
+        // Counting sort of the local block by new owner, keeping global order per destination
+        array<int> partition(commSize);
+        std::fill(partition.begin(), partition.end(), 0);
+        std::vector<int> owners(data_.size());
+        for (size_t i = 0; i < data_.size(); ++i) {
+            owners[i] = target.owner(globalIndex(i));
+            ++partition[static_cast<size_t>(owners[i])];
+        }
+        const array<int> displs = displacements(partition);
+        std::vector<size_t> cursor(displs.begin(), displs.end());
+        array<T, A> packed(data_.size());
+        for (size_t i = 0; i < data_.size(); ++i) {
+            packed[cursor[static_cast<size_t>(owners[i])]++] = data_[i];
+        }
+        const array<T, A> received = allToAllv<T, A>(local_->forward(std::move(packed)), partition);
+
+        // Runs arrive ordered by source rank, each in increasing global index
+        const size_t size = target.localSize(rank);
+        std::vector<int> sources(size);
+        std::vector<size_t> offsets(commSize + 1, 0);
+        for (size_t j = 0; j < size; ++j) {
+            sources[j] = layout_.owner(target.global(rank, j));
+            ++offsets[static_cast<size_t>(sources[j]) + 1];
+        }
+        for (size_t i = 0; i < commSize; ++i) {
+            offsets[i + 1] += offsets[i];
+        }
+        array<T, A> block(size);
+        for (size_t j = 0; j < size; ++j) {
+            block[j] = received[offsets[static_cast<size_t>(sources[j])]++];
+        }
+        return DistributedArray(local_, target, std::move(block));
+    }
+
+    /// Global index of the index-th local element
+    [[nodiscard]] size_t globalIndex(const size_t index) const {
+        return layout_.global(local_->rank(), index);
+    }
+
+    [[nodiscard]] bool isLocal(const size_t global) const {
+        return global < layout_.size() && layout_.owner(global) == local_->rank();
+    }
+
+    /// Element at global index, which must be owned by this rank
+    [[nodiscard]] T& at(const size_t global) const {
+        if (!isLocal(global)) {
+            throw std::out_of_range("DistributedArray::at: index not owned by this rank");
+        }
+        return data_[layout_.local(global)];
+    }
+
+    /// The local block, accepted by every operation
+    [[nodiscard]] array_view<T> view() const { return array_view<T>(data_.data(), data_.size()); }
+
+    [[nodiscard]] const array<T, A>& local() const { return data_; }
+
+    [[nodiscard]] const Layout& layout() const { return layout_; }
+
+    /// Global number of elements
+    [[nodiscard]] size_t size() const { return layout_.size(); }
+
+    [[nodiscard]] size_t localSize() const { return data_.size(); }
+
+private:
+
+    void checkLayout() const {
+        if (layout_.commSize() != static_cast<size_t>(local_->commSize())) {
+            throw std::invalid_argument("DistributedArray: layout made for another communicator size");
+        }
+    }
+
+    std::shared_ptr<const LocalProcess> local_;
+
+    Layout layout_;
+
+    array<T, A> data_;
+
+};
+
+}
+
+#endif //DISTRIBUTED_ARRAY_H
@@ -0,0 +1,151 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <mpi.h>
+#include <array.h>
+
+
+
+namespace mpi {
+
+/// Lazy element-wise map over an array or another Transform. Nothing is evaluated until a
+/// reduction consumes the expression, which then applies every nested function in one pass.
+template<typename Source, typename Func>
+class Transform {
+public:
+
+    Transform(Source&& source, Func func) : source_(std::move(source)), func_(std::move(func)) {}
+
+    /// Element i of the mapped sequence
+    [[nodiscard]] decltype(auto) operator()(const size_t i) const {
+        if constexpr (is_transform<Source>::value) {
+            return func_(source_(i));
+        } else {
+            return func_(source_.data()[i]);
+        }
+    }
+
+    [[nodiscard]] size_t size() const { return source_.size(); }
+
+private:
+
+    template<typename S>
+    struct is_transform : std::false_type {};
+
+    template<typename S, typename F>
+    struct is_transform<Transform<S, F>> : std::true_type {};
+
+    Source source_;
+
+    Func func_;
+
+};
+
+/// Element type a Transform evaluates to
+template<typename E>
+using expression_t = std::remove_cvref_t<decltype(std::declval<const E&>()(size_t{0}))>;
+
+/// Maps func over chunk, e.g. allReduce(*local + transform(std::move(chunk), f))
+template<typename T, typename A, typename Func>
+[[nodiscard]] Transform<array<T, A>, std::decay_t<Func>> transform(array<T, A>&& chunk, Func&& func) {
+    return {std::move(chunk), std::forward<Func>(func)};
+}
+
+/// Composes func after the functions of expr
+template<typename S, typename F, typename Func>
+[[nodiscard]] Transform<Transform<S, F>, std::decay_t<Func>> transform(Transform<S, F>&& expr, Func&& func) {
+    return {std::move(expr), std::forward<Func>(func)};
+}
+
+/// C++ counterparts of the predefined MPI_Ops, used to pre-reduce expressions locally.
+/// identity() lets ranks without elements take part in a scalar reduction.
+namespace reduction {
+
+struct Sum {
+    template<typename T> T operator()(const T& a, const T& b) const { return a + b; }
+    template<typename T> static constexpr T identity() { return T(0); }
+    static MPI_Op op() { return MPI_SUM; }
+};
+
+struct Prod {
+    template<typename T> T operator()(const T& a, const T& b) const { return a * b; }
+    template<typename T> static constexpr T identity() { return T(1); }
+    static MPI_Op op() { return MPI_PROD; }
+};
+
+struct Max {
+    template<typename T> T operator()(const T& a, const T& b) const { return a < b ? b : a; }
+    template<typename T> static constexpr T identity() { return std::numeric_limits<T>::lowest(); }
+    static MPI_Op op() { return MPI_MAX; }
+};
+
+struct Min {
+    template<typename T> T operator()(const T& a, const T& b) const { return b < a ? b : a; }
+    template<typename T> static constexpr T identity() { return std::numeric_limits<T>::max(); }
+    static MPI_Op op() { return MPI_MIN; }
+};
+
+struct BitAnd {
+    template<typename T> T operator()(const T& a, const T& b) const { return a & b; }
+    template<typename T> static constexpr T identity() { return static_cast<T>(~T(0)); }
+    static MPI_Op op() { return MPI_BAND; }
+};
+
+struct BitOr {
+    template<typename T> T operator()(const T& a, const T& b) const { return a | b; }
+    template<typename T> static constexpr T identity() { return T(0); }
+    static MPI_Op op() { return MPI_BOR; }
+};
+
+struct BitXor {
+    template<typename T> T operator()(const T& a, const T& b) const { return a ^ b; }
+    template<typename T> static constexpr T identity() { return T(0); }
+    static MPI_Op op() { return MPI_BXOR; }
+};
+
+}
+
+/// Writes every element of expr to out in one pass
+template<typename E>
+void evaluate(const E& expr, expression_t<E>* __restrict out) {
+    const size_t size = expr.size();
+    for (size_t i = 0; i < size; ++i) {
+        out[i] = expr(i);
+    }
+}
+
+/// Folds the elements of expr with op in one pass. Independent partial results per lane break
+/// the loop-carried dependency, so the loop vectorizes without reassociating floating point
+/// math behind the compiler's back.
+template<typename Op, typename E>
+[[nodiscard]] expression_t<E> fold(const E& expr, const Op& op) {
+    using U = expression_t<E>;
+    constexpr size_t lanes = 8;
+    U partial[lanes];
+    for (auto& value : partial) {
+        value = Op::template identity<U>();
+    }
+    const size_t size = expr.size();
+    const size_t body = size - size % lanes;
+    for (size_t i = 0; i < body; i += lanes) {
+        for (size_t k = 0; k < lanes; ++k) {
+            partial[k] = op(partial[k], expr(i + k));
+        }
+    }
+    for (size_t i = body; i < size; ++i) {
+        partial[i - body] = op(partial[i - body], expr(i));
+    }
+    U result = partial[0];
+    for (size_t k = 1; k < lanes; ++k) {
+        result = op(result, partial[k]);
+    }
+    return result;
+}
+
+}
+
+#endif //EXPRESSION_H
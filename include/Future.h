@@ -0,0 +1,93 @@
+#ifndef FUTURE_H
+#define FUTURE_H
+
+#include <utility>
+#include <mpi.h>
+#include <Trace.h>
+#include <array.h>
+
+
+
+namespace mpi {
+
+/// Handle returned by the non-blocking collectives. Owns the MPI_Request together with
+/// every buffer MPI may still touch. The buffers live on the heap and the request is a handle,
+/// so the operation stays valid however the Future is moved.
+template<typename T, typename A = new_allocator<T>>
+class Future {
+public:
+
+    explicit Future(array<T, A>&& src, array<T, A>&& result, array<int>&& counts = array<int>())
+        : src_(std::move(src)), result_(std::move(result)), counts_(std::move(counts)) {}
+
+    Future(const Future& other) = delete;
+
+    Future(Future&& other) noexcept
+        : src_(std::move(other.src_)), result_(std::move(other.result_)), counts_(std::move(other.counts_)),
+          request_(std::exchange(other.request_, MPI_REQUEST_NULL)) {}
+
+    Future& operator=(const Future& other) = delete;
+
+    /// Completes the pending operation before releasing its buffers for those of other
+    Future& operator=(Future&& other) noexcept {
+        if (this != &other) {
+            complete();
+            src_ = std::move(other.src_);
+            result_ = std::move(other.result_);
+            counts_ = std::move(other.counts_);
+            request_ = std::exchange(other.request_, MPI_REQUEST_NULL);
+        }
+        return *this;
+    }
+
+    ~Future() {
+        complete();
+    }
+
+    /// Blocks until the operation completes and hands over the result
+    array<T, A> operator()() {
+        const trace::Span span("wait", 0, -1, MPI_DATATYPE_NULL);
+        MPI_Wait(&request_, MPI_STATUS_IGNORE);
+        src_ = array<T, A>();
+        return std::move(result_);
+    }
+
+    /// Returns true once the operation has completed, without blocking
+    [[nodiscard]] bool test() const {
+        int flag = 0;
+        MPI_Test(&request_, &flag, MPI_STATUS_IGNORE);
+        return flag != 0;
+    }
+
+    /// The request lives inside the Future, the pointer is invalidated by moving it
+    [[nodiscard]] MPI_Request* request() const { return &request_; }
+
+    [[nodiscard]] const array<T, A>& src() const { return src_; }
+
+    [[nodiscard]] const array<T, A>& result() const { return result_; }
+
+    [[nodiscard]] const array<int>& counts() const { return counts_; }
+
+private:
+
+    void complete() noexcept {
+        int finalized = 0;
+        MPI_Finalized(&finalized);
+        if (request_ != MPI_REQUEST_NULL && !finalized) {
+            MPI_Wait(&request_, MPI_STATUS_IGNORE);
+        }
+    }
+
+    array<T, A> src_;
+
+    array<T, A> result_;
+
+    array<int> counts_;
+
+    mutable MPI_Request request_ = MPI_REQUEST_NULL;
+
+};
+
+}
+
+#endif //FUTURE_H
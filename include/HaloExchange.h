@@ -0,0 +1,293 @@
+#ifndef HALO_EXCHANGE_H
+#define HALO_EXCHANGE_H
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include <mpi.h>
+#include <Cartesian.h>
+#include <Communicator.h>
+#include <Trace.h>
+#include <array.h>
+#include <mpi_types.h>
+
+
+
+namespace mpi {
+
+/// N-dimensional block of a Cartesian grid padded by width ghost cells on every face, with
+/// persistent requests refreshing the ghosts from the face neighbours. Every face is described
+/// by an MPI_Type_create_subarray over the padded block, so neither side packs a copy.
+/// All 4 * ndims transfers run concurrently, hence edge and corner ghosts are not filled
+/// (enough for star stencils). Construction is collective over the grid.
+///
+///     halo.start();
+///     halo.forEachInterior(update);  // reads no ghost, overlaps the exchange
+///     halo.wait();
+///     halo.forEachBoundary(update);
+template<typename T, typename A = new_allocator<T>>
+class HaloExchange {
+public:
+
+    /// sizes are the owned cells per dimension, row-major with the last dimension contiguous
+    HaloExchange(const Cartesian& grid, std::vector<int> sizes, const int width = 1)
+        : comm_(grid.communicator()->dup()), sizes_(std::move(sizes)), width_(width) {
+        if (static_cast<int>(sizes_.size()) != grid.ndims()) {
+            throw std::invalid_argument("HaloExchange: need one size per grid dimension");
+        }
+        if (width_ < 1 || std::any_of(sizes_.begin(), sizes_.end(), [&](const int size) { return size < width_; })) {
+            throw std::invalid_argument("HaloExchange: width must be positive and fit every size");
+        }
+        const size_t ndims = sizes_.size();
+        extents_.resize(ndims);
+        strides_.resize(ndims);
+        size_t cells = 1;
+        for (size_t d = ndims; d-- > 0;) {
+            extents_[d] = sizes_[d] + 2 * width_;
+            strides_[d] = cells;
+            cells *= static_cast<size_t>(extents_[d]);
+        }
+        data_ = array<T, A>(cells);
+        std::fill(data_.begin(), data_.end(), T());
+
+        if constexpr (is_mpi_type<T>::value) {
+            element_ = get_mpi_type<T>();
+        } else {
+            MPI_Type_contiguous(static_cast<int>(sizeof(T)), MPI_BYTE, &element_);
+            MPI_Type_commit(&element_);
+            ownsElement_ = true;
+        }
+
+        // The destructor does not run for a throwing constructor, release what was built so far
+        try {
+            faces_.reserve(4 * ndims);
+            requests_.reserve(4 * ndims);
+            for (int d = 0; d < static_cast<int>(ndims); ++d) {
+                const auto [lower, upper] = grid.shift(d);
+                const int size = sizes_[static_cast<size_t>(d)];
+                // Upwards: own upper face to the upper neighbour, lower ghosts from the lower one
+                addTransfer(d, size, upper, 2 * d, true);
+                addTransfer(d, 0, lower, 2 * d, false);
+                // Downwards
+                addTransfer(d, width_, lower, 2 * d + 1, true);
+                addTransfer(d, size + width_, upper, 2 * d + 1, false);
+            }
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    HaloExchange(const HaloExchange& other) = delete;
+
+    HaloExchange& operator=(const HaloExchange& other) = delete;
+
+    ~HaloExchange() {
+        int finalized = 0;
+        MPI_Finalized(&finalized);
+        if (finalized) {
+            return;
+        }
+        if (active_) {
+            wait();
+        }
+        release();
+    }
+
+    /// Posts every face transfer and returns, the ghosts may only be read after wait()
+    void start() {
+        if (active_) {
+            throw std::logic_error("HaloExchange::start");
+        }
+        const trace::Span span("haloStart", haloBytes(), -1, element_);
+        MPI_Startall(static_cast<int>(requests_.size()), requests_.data());
+        active_ = true;
+    }
+
+    void wait() {
+        const trace::Span span("haloWait", haloBytes(), -1, element_);
+        MPI_Waitall(static_cast<int>(requests_.size()), requests_.data(), MPI_STATUSES_IGNORE);
+        active_ = false;
+    }
+
+    /// Returns true once every transfer of the current exchange completed
+    bool test() {
+        int flag;
+        MPI_Testall(static_cast<int>(requests_.size()), requests_.data(), &flag, MPI_STATUSES_IGNORE);
+        active_ = active_ && !flag;
+        return flag;
+    }
+
+    void exchange() {
+        start();
+        wait();
+    }
+
+    /// Cell at owned coordinates, ghosts lie at -width..-1 and size..size + width - 1
+    template<typename... I>
+    [[nodiscard]] T& operator()(const I... index) const {
+        if (sizeof...(I) != sizes_.size()) {
+            throw std::invalid_argument("HaloExchange: wrong number of coordinates");
+        }
+        size_t d = 0;
+        size_t offset = 0;
+        ((offset += static_cast<size_t>(static_cast<long>(index) + width_) * strides_[d++]), ...);
+        return data_[offset];
+    }
+
+    /// Runs f(offset) for every owned cell at least width away from each face, i.e. every cell a
+    /// stencil of radius width can update without ghosts. Neighbours are at offset +- stride(d).
+    template<typename Func>
+    void forEachInterior(Func&& f) const {
+        std::vector<int> lower(sizes_.size(), width_);
+        std::vector<int> upper(sizes_.size());
+        for (size_t d = 0; d < sizes_.size(); ++d) {
+            upper[d] = sizes_[d] - width_;
+        }
+        forEachIn(lower, upper, f);
+    }
+
+    /// Runs f(offset) for the owned cells forEachInterior() skips
+    template<typename Func>
+    void forEachBoundary(Func&& f) const {
+        const size_t ndims = sizes_.size();
+        // Slab d: interior range below d, a face band in d, everything above d
+        for (size_t d = 0; d < ndims; ++d) {
+            std::vector<int> lower(ndims, 0);
+            std::vector<int> upper(sizes_);
+            for (size_t e = 0; e < d; ++e) {
+                lower[e] = width_;
+                upper[e] = sizes_[e] - width_;
+            }
+            upper[d] = std::min(width_, sizes_[d]);
+            forEachIn(lower, upper, f);
+            lower[d] = std::max(width_, sizes_[d] - width_);
+            upper[d] = sizes_[d];
+            forEachIn(lower, upper, f);
+        }
+    }
+
+    /// The padded block, ghosts included
+    [[nodiscard]] array<T, A>& data() { return data_; }
+
+    [[nodiscard]] const array<T, A>& data() const { return data_; }
+
+    [[nodiscard]] size_t stride(const size_t dim) const { return strides_[dim]; }
+
+    [[nodiscard]] const std::vector<int>& sizes() const { return sizes_; }
+
+    [[nodiscard]] int width() const { return width_; }
+
+private:
+
+    /// Frees the persistent requests and datatypes, none may be active
+    void release() noexcept {
+        for (auto& request : requests_) {
+            if (request != MPI_REQUEST_NULL) {
+                MPI_Request_free(&request);
+            }
+        }
+        for (auto& type : faces_) {
+            MPI_Type_free(&type);
+        }
+        if (ownsElement_) {
+            MPI_Type_free(&element_);
+            ownsElement_ = false;
+        }
+        requests_.clear();
+        faces_.clear();
+    }
+
+    /// Persistent send (or receive) of the width-deep slab starting at start along dim
+    void addTransfer(const int dim, const int start, const int peer, const int tag, const bool send) {
+        std::vector<int> subsizes(sizes_);
+        std::vector<int> starts(sizes_.size(), width_);
+        subsizes[static_cast<size_t>(dim)] = width_;
+        starts[static_cast<size_t>(dim)] = start;
+        MPI_Datatype face;
+        MPI_Type_create_subarray(static_cast<int>(sizes_.size()), extents_.data(), subsizes.data(), starts.data(),
+                                 MPI_ORDER_C, element_, &face);
+        MPI_Type_commit(&face);
+        faces_.push_back(face);
+        requests_.push_back(MPI_REQUEST_NULL);
+        if (send) {
+            MPI_Send_init(data_.data(), 1, face, peer, tag, comm_->get(), &requests_.back());
+        } else {
+            MPI_Recv_init(data_.data(), 1, face, peer, tag, comm_->get(), &requests_.back());
+        }
+    }
+
+    /// Visits the owned box [lower, upper) in memory order
+    template<typename Func>
+    void forEachIn(const std::vector<int>& lower, const std::vector<int>& upper, Func& f) const {
+        const size_t ndims = sizes_.size();
+        for (size_t d = 0; d < ndims; ++d) {
+            if (lower[d] >= upper[d]) {
+                return;
+            }
+        }
+        std::vector<int> index(lower);
+        const size_t last = ndims - 1;
+        while (true) {
+            size_t offset = 0;
+            for (size_t d = 0; d < ndims; ++d) {
+                offset += static_cast<size_t>(index[d] + width_) * strides_[d];
+            }
+            for (int i = lower[last]; i < upper[last]; ++i) {
+                f(offset + static_cast<size_t>(i - lower[last]));
+            }
+            // Odometer over the outer dimensions
+            size_t d = last;
+            while (d-- > 0) {
+                if (++index[d] < upper[d]) {
+                    break;
+                }
+                index[d] = lower[d];
+            }
+            if (d == static_cast<size_t>(-1)) {
+                return;
+            }
+        }
+    }
+
+    [[nodiscard]] size_t haloBytes() const {
+        size_t owned = 1;
+        for (const int size : sizes_) {
+            owned *= static_cast<size_t>(size);
+        }
+        size_t cells = 0;
+        for (const int size : sizes_) {
+            cells += 2 * static_cast<size_t>(width_) * (owned / static_cast<size_t>(size));
+        }
+        return cells * sizeof(T);
+    }
+
+    std::shared_ptr<Communicator> comm_;
+
+    std::vector<int> sizes_;
+
+    int width_;
+
+    std::vector<int> extents_;
+
+    std::vector<size_t> strides_;
+
+    array<T, A> data_;
+
+    MPI_Datatype element_ = MPI_DATATYPE_NULL;
+
+    bool ownsElement_ = false;
+
+    std::vector<MPI_Datatype> faces_;
+
+    std::vector<MPI_Request> requests_;
+
+    bool active_ = false;
+
+};
+
+}
+
+#endif //HALO_EXCHANGE_H
@@ -2,9 +2,13 @@
 #define LOCALPROCESS_H
 
 #include <functional>
+#include <Expression.h>
+#include <Message.h>
 #include <Process.h>
 #include <array.h>
+#include <array_view.h>
 #include <mpi.h>
+#include <mpi_ops.h>
 #include <mpi_types.h>
 
 
@@ -38,31 +42,37 @@ public:
 
     /// Datatype returned after using overloaded ops and needed to perform mpi::reduce(),
     /// mpi::allReduce(), mpi::scan(), mpi::reduceScatter()
-    template<typename T>
-    using arith_op_args = std::tuple<const LocalProcess&, array<T>, MPI_Op>;
+    template<typename T, typename A = new_allocator<T>>
+    using arith_op_args = std::tuple<const LocalProcess&, array<T, A>, MPI_Op>;
 
-    template<typename T>
-    using in_op_args = std::tuple<const LocalProcess&, array<T>, size_t>;
+    template<typename T, typename A = new_allocator<T>>
+    using in_op_args = std::tuple<const LocalProcess&, array<T, A>, size_t>;
 
-    template<typename T>
-    using out_op_args = std::tuple<const LocalProcess&, array<T>>;
+    template<typename T, typename A = new_allocator<T>>
+    using out_op_args = std::tuple<const LocalProcess&, array<T, A>>;
 
-    explicit LocalProcess(const int rank, const int commSize) : Process(rank, commSize) {}
+    /// Lazy expression (see transform()) with the reduction to apply, built by the same operators
+    template<typename E, typename Op>
+    using expr_op_args = std::tuple<const LocalProcess&, E, Op>;
 
-    // Assigns new Root Process
+    /// The calling rank within comm
+    explicit LocalProcess(std::shared_ptr<Communicator> comm)
+        : Process(comm, comm->rank()) {}
+
+    // Assigns new Root Process of this communicator
     void operator()(const int newRoot) const {
-        ROOT = newRoot;
+        comm_->setRoot(newRoot);
     }
 
     /// Runs on root
     void operator()(const std::function<void()>& func) const {
-        if (this->rank_ == ROOT) {
+        if (this->rank_ == root()) {
             func();
         }
     }
 
     auto operator~() const {
-        return ProcessFunctor([this] { return rank_ != ROOT; });
+        return ProcessFunctor([this] { return rank_ != root(); });
     }
 
     auto operator[](const int runOn) const {
@@ -72,13 +82,13 @@ public:
         throw std::out_of_range("LocalProcess::operator[]");
     }
 
-    template<typename T, typename Func, typename... Args>
-    in_op_args<T> init(Func&& initData, size_t size, const Args&... args) const {
+    template<typename T, typename A = new_allocator<T>, typename Func, typename... Args>
+    in_op_args<T, A> init(Func&& initData, size_t size, const Args&... args) const {
         size = roundup(size);
 
-        array<T> data;
-        if (this->rank_ == ROOT) {
-            data = array<T>(size);
+        array<T, A> data;
+        if (this->rank_ == root()) {
+            data = array<T, A>(size);
             initData(data, args...);
 
         }
@@ -86,87 +96,163 @@ public:
     }
 
     /// Initializes an array for scatter operation with 0
-    template<typename T>
-    in_op_args<T> init(size_t size) const {
+    template<typename T, typename A = new_allocator<T>>
+    in_op_args<T, A> init(size_t size) const {
         size = roundup(size);
 
-        array<T> data;
-        if (this->rank_ == ROOT) {
-            data = array<T>(size);
+        array<T, A> data;
+        if (this->rank_ == root()) {
+            data = array<T, A>(size);
             data.clear();
         }
         return {*this, std::move(data), size};
     }
 
+    /// Like init() but keeps the exact size, for the variable-count scatterv()
+    template<typename T, typename A = new_allocator<T>, typename Func, typename... Args>
+    in_op_args<T, A> initv(Func&& initData, const size_t size, const Args&... args) const {
+        array<T, A> data;
+        if (this->rank_ == root()) {
+            data = array<T, A>(size);
+            initData(data, args...);
+        }
+        return {*this, std::move(data), size};
+    }
+
+    /// Binds existing root data, e.g. an array_view, for scatter()/scatterv()/broadcast().
+    /// size must be known on every rank, data is only read on root.
+    template<typename T, typename A>
+    in_op_args<T, A> bind(array<T, A>&& data, const size_t size) const {
+        return {*this, std::move(data), size};
+    }
+
+    /// Receives the next message from any peer in arrival order, sized from its envelope
+    template<typename T, typename A = new_allocator<T>>
+    [[nodiscard]] Message<T, A> receive(const int tag = MPI_ANY_TAG) const {
+        return mpi::receive<T, A>(MPI_ANY_SOURCE, tag, comm());
+    }
+
+    /// Non-blocking receive(), std::nullopt when no message is pending
+    template<typename T, typename A = new_allocator<T>>
+    [[nodiscard]] std::optional<Message<T, A>> tryReceive(const int tag = MPI_ANY_TAG) const {
+        return mpi::tryReceive<T, A>(MPI_ANY_SOURCE, tag, comm());
+    }
+
     /// Binds chunk with LocalProcess
-    template<typename T>
-    out_op_args<T> forward(array<T>&& chunk) const {
+    template<typename T, typename A>
+    out_op_args<T, A> forward(array<T, A>&& chunk) const {
         return {*this, std::move(chunk)};
     }
 
-    template<typename T>
-    [[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, arith_op_args<T>>
-    max(array<T>&& data) const {
+    template<typename T, typename A>
+    [[nodiscard]] std::enable_if_t<is_builtin_mpi_type<T>::value, arith_op_args<T, A>>
+    max(array<T, A>&& data) const {
         return {*this, std::move(data), MPI_MAX};
     }
 
-    template<typename T>
-    [[nodiscard]]std::enable_if_t<is_mpi_type<T>::value, arith_op_args<T>>
-    min(array<T> data) const {
+    template<typename T, typename A>
+    [[nodiscard]]std::enable_if_t<is_builtin_mpi_type<T>::value, arith_op_args<T, A>>
+    min(array<T, A> data) const {
         return {*this, std::move(data), MPI_MIN};
     }
 
-    template<typename T>
-    [[nodiscard]]std::enable_if_t<is_mpi_type<T>::value, arith_op_args<T>>
-    operator+(array<T>&& data) const {
+    template<typename T, typename A>
+    [[nodiscard]]std::enable_if_t<is_builtin_mpi_type<T>::value, arith_op_args<T, A>>
+    operator+(array<T, A>&& data) const {
         return {*this, std::move(data), MPI_SUM};
     }
 
-    template<typename T>
-    [[nodiscard]]std::enable_if_t<is_mpi_type<T>::value, arith_op_args<T>>
-    operator*(array<T>&& data) const {
+    template<typename T, typename A>
+    [[nodiscard]]std::enable_if_t<is_builtin_mpi_type<T>::value, arith_op_args<T, A>>
+    operator*(array<T, A>&& data) const {
         return {*this, std::move(data), MPI_PROD};
     }
 
-    template<typename T>
-    [[nodiscard]]std::enable_if_t<is_mpi_type<T>::value &&
-    !std::is_same_v<T, float> && !std::is_same_v<T, double>,arith_op_args<T>>
-    operator&&(array<T>&& data) const {
-        return {*this, std::move(data) MPI_LAND};
+    template<typename T, typename A>
+    [[nodiscard]]std::enable_if_t<is_builtin_mpi_type<T>::value &&
+    !std::is_same_v<T, float> && !std::is_same_v<T, double>,arith_op_args<T, A>>
+    operator&&(array<T, A>&& data) const {
+        return {*this, std::move(data), MPI_LAND};
     }
 
-    template<typename T>
-    [[nodiscard]]std::enable_if_t<!std::is_same_v<T, float> && !std::is_same_v<T, double>, arith_op_args<T>>
-    operator&(array<T>&& data) const {
+    template<typename T, typename A>
+    [[nodiscard]]std::enable_if_t<is_builtin_mpi_type<T>::value &&
+    !std::is_same_v<T, float> && !std::is_same_v<T, double>, arith_op_args<T, A>>
+    operator&(array<T, A>&& data) const {
         return {*this, std::move(data), MPI_BAND};
     }
 
-    template<typename T>
-    [[nodiscard]] std::enable_if_t<is_mpi_type<T>::value &&
-    !std::is_same_v<T, float> && !std::is_same_v<T, double>, arith_op_args<T>>
-    operator||(array<T>&& data) const {
+    template<typename T, typename A>
+    [[nodiscard]] std::enable_if_t<is_builtin_mpi_type<T>::value &&
+    !std::is_same_v<T, float> && !std::is_same_v<T, double>, arith_op_args<T, A>>
+    operator||(array<T, A>&& data) const {
         return{*this, std::move(data), MPI_LOR};
     }
 
-    template<typename T>
-    [[nodiscard]] std::enable_if_t<!std::is_same_v<T, float> && !std::is_same_v<T, double>,arith_op_args<T>>
-    operator|(array<T> data) const {
+    template<typename T, typename A>
+    [[nodiscard]] std::enable_if_t<is_builtin_mpi_type<T>::value &&
+    !std::is_same_v<T, float> && !std::is_same_v<T, double>, arith_op_args<T, A>>
+    operator|(array<T, A> data) const {
         return {*this, std::move(data), MPI_BOR};
     }
 
-    template<typename T>
-    [[nodiscard]] std::enable_if_t<is_mpi_type<T>::value &&
-    !std::is_same_v<T, float> && !std::is_same_v<T, double>, arith_op_args<T>>
-    operator!=(array<T>&& data) const {
+    template<typename T, typename A>
+    [[nodiscard]] std::enable_if_t<is_builtin_mpi_type<T>::value &&
+    !std::is_same_v<T, float> && !std::is_same_v<T, double>, arith_op_args<T, A>>
+    operator!=(array<T, A>&& data) const {
         return {*this, std::move(data), MPI_LXOR};
     }
 
-    template<typename T>
-    [[nodiscard]] std::enable_if_t<!std::is_same_v<T, float> && !std::is_same_v<T, double>, arith_op_args<T>>
-    operator^(array<T>&& data) const {
+    template<typename T, typename A>
+    [[nodiscard]] std::enable_if_t<is_builtin_mpi_type<T>::value &&
+    !std::is_same_v<T, float> && !std::is_same_v<T, double>, arith_op_args<T, A>>
+    operator^(array<T, A>&& data) const {
         return {*this, std::move(data), MPI_BXOR};
     }
 
+    template<typename S, typename F>
+    [[nodiscard]] expr_op_args<Transform<S, F>, reduction::Sum> operator+(Transform<S, F>&& expr) const {
+        return {*this, std::move(expr), {}};
+    }
+
+    template<typename S, typename F>
+    [[nodiscard]] expr_op_args<Transform<S, F>, reduction::Prod> operator*(Transform<S, F>&& expr) const {
+        return {*this, std::move(expr), {}};
+    }
+
+    template<typename S, typename F>
+    [[nodiscard]] expr_op_args<Transform<S, F>, reduction::BitAnd> operator&(Transform<S, F>&& expr) const {
+        return {*this, std::move(expr), {}};
+    }
+
+    template<typename S, typename F>
+    [[nodiscard]] expr_op_args<Transform<S, F>, reduction::BitOr> operator|(Transform<S, F>&& expr) const {
+        return {*this, std::move(expr), {}};
+    }
+
+    template<typename S, typename F>
+    [[nodiscard]] expr_op_args<Transform<S, F>, reduction::BitXor> operator^(Transform<S, F>&& expr) const {
+        return {*this, std::move(expr), {}};
+    }
+
+    template<typename S, typename F>
+    [[nodiscard]] expr_op_args<Transform<S, F>, reduction::Max> max(Transform<S, F>&& expr) const {
+        return {*this, std::move(expr), {}};
+    }
+
+    template<typename S, typename F>
+    [[nodiscard]] expr_op_args<Transform<S, F>, reduction::Min> min(Transform<S, F>&& expr) const {
+        return {*this, std::move(expr), {}};
+    }
+
+    /// Reduces with a captureless binary lambda turned into a cached MPI_Op,
+    /// pass Commute = false for non-commutative operations
+    template<bool Commute = true, typename T, typename A, typename Func>
+    [[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, arith_op_args<T, A>>
+    custom(Func&&, array<T, A>&& data) const {
+        return {*this, std::move(data), get_mpi_op<T, std::decay_t<Func>, Commute>()};
+    }
+
 private:
 
     [[nodiscard]] size_t roundup(const size_t size) const {
@@ -1,21 +1,46 @@
 #ifndef MPIENVIRONMENT_H
 #define MPIENVIRONMENT_H
 
+#include <Communicator.h>
 #include <LocalProcess.h>
+#include <ProgressThread.h>
 #include <RemoteProcess.h>
 
+#include <memory>
+#include <mpi.h>
 #include <vector>
 
 
 namespace mpi {
 
+/// Thread support levels of MPI_Init_thread, in increasing order
+enum class Threading : int {
+    Single = MPI_THREAD_SINGLE,
+    Funneled = MPI_THREAD_FUNNELED,
+    Serialized = MPI_THREAD_SERIALIZED,
+    Multiple = MPI_THREAD_MULTIPLE
+};
+
 class MPIEnvironment {
 public:
 
     MPIEnvironment(int &argc, char** &argv);
 
+    /// Initializes with MPI_Init_thread, throws if the library provides less than required.
+    /// progress starts a ProgressThread on the world communicator and needs Threading::Multiple.
+    MPIEnvironment(int &argc, char** &argv, Threading required, bool progress = false);
+
     [[nodiscard]] int getCommSize() const;
 
+    /// Thread support level provided by the library
+    [[nodiscard]] Threading getThreading() const;
+
+    /// nullptr unless a progress thread was requested
+    [[nodiscard]] const ProgressThread* getProgressThread() const;
+
+    /// MPI_COMM_WORLD, split() or dup() it for sub-groups
+    [[nodiscard]] std::weak_ptr<Communicator> getWorld() const;
+
     [[nodiscard]] std::weak_ptr<LocalProcess> getLocalProcess() const;
 
     [[nodiscard]] std::weak_ptr<std::vector<RemoteProcess>> getRemoteProcesses() const;
@@ -24,13 +49,22 @@ public:
 
 private:
 
+    /// Builds the processes once MPI is initialized
+    explicit MPIEnvironment(Threading provided);
+
+    Threading threading_;
+
     int commSize_;
 
+    std::shared_ptr<Communicator> world_;
+
     std::shared_ptr<LocalProcess> local_process_;
 
     std::shared_ptr<std::vector<RemoteProcess>> remote_processes_ =
         std::make_shared<std::vector<RemoteProcess>>();
 
+    std::unique_ptr<ProgressThread> progress_;
+
 };
 
 }
@@ -0,0 +1,69 @@
+#ifndef MESSAGE_H
+#define MESSAGE_H
+
+#include <optional>
+#include <mpi.h>
+#include <array.h>
+#include <large_count.h>
+#include <mpi_types.h>
+
+
+
+namespace mpi {
+
+/// A received message sized from its envelope, together with where it came from
+template<typename T, typename A = new_allocator<T>>
+struct Message {
+
+    int source;
+
+    int tag;
+
+    array<T, A> data;
+
+};
+
+/// Receives the message matched by MPI_Mprobe/MPI_Improbe into an array of exactly its size
+template<typename T, typename A>
+std::enable_if_t<!is_mpi_type<T>::value, Message<T, A>>
+receiveMatched(MPI_Message& message, const MPI_Status& status) {
+    const size_t count = large::getCount(status, MPI_BYTE);
+    array<T, A> data(count / sizeof(T));
+    large::mrecv(data.data(), count, MPI_BYTE, &message);
+    return {status.MPI_SOURCE, status.MPI_TAG, std::move(data)};
+}
+
+template<typename T, typename A>
+std::enable_if_t<is_mpi_type<T>::value, Message<T, A>>
+receiveMatched(MPI_Message& message, const MPI_Status& status) {
+    const size_t count = large::getCount(status, get_mpi_type<T>(), basic_element_count<T>());
+    array<T, A> data(count);
+    large::mrecv(data.data(), count, get_mpi_type<T>(), &message);
+    return {status.MPI_SOURCE, status.MPI_TAG, std::move(data)};
+}
+
+/// Blocks for the next message from source (or MPI_ANY_SOURCE) with tag (or MPI_ANY_TAG)
+template<typename T, typename A = new_allocator<T>>
+Message<T, A> receive(const int source, const int tag, MPI_Comm comm) {
+    MPI_Message message;
+    MPI_Status status;
+    MPI_Mprobe(source, tag, comm, &message, &status);
+    return receiveMatched<T, A>(message, status);
+}
+
+/// Like receive() but returns std::nullopt instead of blocking when nothing is pending
+template<typename T, typename A = new_allocator<T>>
+std::optional<Message<T, A>> tryReceive(const int source, const int tag, MPI_Comm comm) {
+    int flag = 0;
+    MPI_Message message;
+    MPI_Status status;
+    MPI_Improbe(source, tag, comm, &flag, &message, &status);
+    if (!flag) {
+        return std::nullopt;
+    }
+    return receiveMatched<T, A>(message, status);
+}
+
+}
+
+#endif //MESSAGE_H
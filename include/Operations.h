@@ -1,235 +1,1053 @@
 #ifndef OPERATIONS_H
 #define OPERATIONS_H
 
+#include <stdexcept>
+#include <utility>
 #include <mpi_types.h>
+#include <Future.h>
+#include <Plan.h>
+#include <large_count.h>
 #include <LocalProcess.h>
+#include <Trace.h>
 
 
 
 namespace mpi {
 
-template<typename T>
-[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T>>
-scatter(LocalProcess::in_op_args<T>&& args) {
-    auto& [data, commSize, size] = args;
-    const size_t chunkSize = size / commSize;
-    array<T> chunk(chunkSize);
-    const int read = static_cast<int>(sizeof(T) * chunkSize);
-    MPI_Scatter(data.data(), read, MPI_BYTE,
-        chunk.data(), read, MPI_BYTE,
-        Process::ROOT, MPI_COMM_WORLD);
+/// Element counts per rank when size elements are dealt out as evenly as possible,
+/// multiplied by scale (e.g. sizeof(T) for the MPI_BYTE paths)
+inline array<int> balancedCounts(const size_t size, const size_t commSize, const size_t scale = 1) {
+    array<int> counts(commSize);
+    for (size_t i = 0; i < commSize; ++i) {
+        counts[i] = checkedCount((size / commSize + (i < size % commSize ? 1 : 0)) * scale);
+    }
+    return counts;
+}
+
+/// Copy of counts multiplied by scale
+inline array<int> scaledCounts(const array<int>& counts, const size_t scale) {
+    array<int> scaled(counts.size());
+    for (size_t i = 0; i < counts.size(); ++i) {
+        scaled[i] = checkedCount(static_cast<size_t>(counts[i]) * scale);
+    }
+    return scaled;
+}
+
+/// Exclusive prefix sum of counts, i.e. where every rank's block starts
+inline array<int> displacements(const array<int>& counts) {
+    array<int> displs(counts.size());
+    size_t offset = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        displs[i] = checkedCount(offset);
+        offset += static_cast<size_t>(counts[i]);
+    }
+    return displs;
+}
+
+/// Checks a user supplied partition has one entry per rank covering exactly size elements
+inline void checkPartition(const array<int>& partition, const size_t commSize, const size_t size) {
+    if (partition.size() != commSize) {
+        throw std::invalid_argument("mpi: partition needs one count per rank");
+    }
+    size_t total = 0;
+    for (const auto& count : partition) {
+        if (count < 0) {
+            throw std::invalid_argument("mpi: negative count in partition");
+        }
+        total += static_cast<size_t>(count);
+    }
+    if (total != size) {
+        throw std::invalid_argument("mpi: partition does not cover the data");
+    }
+}
+
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+scatter(LocalProcess::in_op_args<T, A>&& args) {
+    auto& [local, data, size] = args;
+    const trace::Span span("scatter", size * sizeof(T), local.root(), MPI_BYTE);
+    const size_t chunkSize = size / static_cast<size_t>(local.commSize());
+    array<T, A> chunk(chunkSize);
+    large::scatter(data.data(), chunk.data(), chunkSize * sizeof(T), MPI_BYTE,
+        local.root(), local.comm());
     return chunk;
 }
 
-template<typename T>
-[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T>>
-scatter(LocalProcess::in_op_args<T>&& args) {
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+scatter(LocalProcess::in_op_args<T, A>&& args) {
     auto& [local, data, size] = args;
+    const trace::Span span("scatter", size * sizeof(T), local.root(), get_mpi_type<T>());
     const size_t chunkSize = size / static_cast<size_t>(local.commSize());
-    array<T> chunk(chunkSize);
-    const int read =  static_cast<int>(chunkSize);
-    MPI_Scatter(data.data(), read, get_mpi_type<T>(),
-        chunk.data(), read, get_mpi_type<T>(),
-        Process::ROOT, MPI_COMM_WORLD);
+    array<T, A> chunk(chunkSize);
+    large::scatter(data.data(), chunk.data(), chunkSize, get_mpi_type<T>(),
+        local.root(), local.comm());
     return chunk;
 }
 
-template<typename T>
-[[nodiscard]]std::enable_if_t<!is_mpi_type<T>::value, array<T>>
-broadcast(LocalProcess::in_op_args<T>&& args) {
+template<typename T, typename A>
+[[nodiscard]]std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+broadcast(LocalProcess::in_op_args<T, A>&& args) {
     auto& [local, data, size] = args;
-    if (local.rank() != Process::ROOT) {
-        data = array<T>(size);
+    const trace::Span span("broadcast", size * sizeof(T), local.root(), MPI_BYTE);
+    if (local.rank() != local.root()) {
+        data = array<T, A>(size);
     }
-    MPI_Bcast(data.data(), static_cast<int>(data.size) * sizeof(T), MPI_BYTE,
-            Process::ROOT, MPI_COMM_WORLD);
+    large::bcast(data.data(), size * sizeof(T), MPI_BYTE,
+        local.root(), local.comm());
     return data;
 }
 
-template<typename T>
-[[nodiscard]]std::enable_if_t<is_mpi_type<T>::value, array<T>>
-broadcast(LocalProcess::in_op_args<T>&& args) {
+template<typename T, typename A>
+[[nodiscard]]std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+broadcast(LocalProcess::in_op_args<T, A>&& args) {
     auto& [local, data, size] = args;
-    if (local.rank() != Process::ROOT) {
-        data = array<T>(size);
+    const trace::Span span("broadcast", size * sizeof(T), local.root(), get_mpi_type<T>());
+    if (local.rank() != local.root()) {
+        data = array<T, A>(size);
     }
-    MPI_Bcast(data.data(), static_cast<int>(data.size()), get_mpi_type<T>(),
-        Process::ROOT, MPI_COMM_WORLD);
+    large::bcast(data.data(), size, get_mpi_type<T>(),
+        local.root(), local.comm());
     return data;
 }
 
-template<typename T>
-[[nodiscard]]std::enable_if_t<!is_mpi_type<T>::value, array<T>>
-gather(LocalProcess::out_op_args<T>&& args) {
+template<typename T, typename A>
+[[nodiscard]]std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+gather(LocalProcess::out_op_args<T, A>&& args) {
     auto& [local, chunk] = args;
-    array<T> data;
-    if (local.rank() == static_cast<int>(Process::ROOT)) {
-        data = array<T>(chunk.size() * local.commSize());
-    }
-    const int read = static_cast<int>(chunk.size()) * sizeof(T);
-    MPI_Gather(chunk.data(), read, MPI_BYTE,
-            data.data(), read, MPI_BYTE,
-            Process::ROOT, MPI_COMM_WORLD);
+    const trace::Span span("gather", chunk.size() * sizeof(T), local.root(), MPI_BYTE);
+    array<T, A> data;
+    if (local.rank() == local.root()) {
+        data = array<T, A>(chunk.size() * static_cast<size_t>(local.commSize()));
+    }
+    const size_t read = chunk.size() * sizeof(T);
+    large::gather(chunk.data(), read, data.data(), read, MPI_BYTE,
+        local.root(), local.comm());
     return data;
 }
 
-template<typename T>
-[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T>>
-gather(LocalProcess::out_op_args<T>&& args) {
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+gather(LocalProcess::out_op_args<T, A>&& args) {
     auto& [local, chunk] = args;
-    array<T> data;
-    if (local.rank() == Process::ROOT) {
-        data = array<T>(chunk.size() * static_cast<size_t>(local.commSize()));
-    }
-    const int read = static_cast<int>(chunk.size());
-    MPI_Gather(chunk.data(), read, get_mpi_type<T>(),
-            data.data(), read, get_mpi_type<T>(),
-            Process::ROOT, MPI_COMM_WORLD);
+    const trace::Span span("gather", chunk.size() * sizeof(T), local.root(), get_mpi_type<T>());
+    array<T, A> data;
+    if (local.rank() == local.root()) {
+        data = array<T, A>(chunk.size() * static_cast<size_t>(local.commSize()));
+    }
+    large::gather(chunk.data(), chunk.size(), data.data(), chunk.size(), get_mpi_type<T>(),
+        local.root(), local.comm());
     return data;
 }
 
-template<typename T>
-[[nodiscard]]std::enable_if_t<!is_mpi_type<T>::value, array<T>>
-allGather(LocalProcess::out_op_args<T>&& args) {
+template<typename T, typename A>
+[[nodiscard]]std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+allGather(LocalProcess::out_op_args<T, A>&& args) {
     auto& [local, chunk] = args;
-    array<T> data(chunk.size() * local.commSize());
-    const int read = static_cast<int>(chunk.size() * sizeof(T));
-    MPI_Allgather(chunk.data(), read, MPI_BYTE,
-            data.data(), read, MPI_BYTE, MPI_COMM_WORLD);
+    const trace::Span span("allGather", chunk.size() * sizeof(T), -1, MPI_BYTE);
+    array<T, A> data(chunk.size() * static_cast<size_t>(local.commSize()));
+    const size_t read = chunk.size() * sizeof(T);
+    large::allGather(chunk.data(), read, data.data(), read, MPI_BYTE, local.comm());
     return data;
 }
 
-template<typename T>
-[[nodiscard]]std::enable_if_t<is_mpi_type<T>::value, array<T>>
-allGather(LocalProcess::out_op_args<T>&& args) {
+template<typename T, typename A>
+[[nodiscard]]std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+allGather(LocalProcess::out_op_args<T, A>&& args) {
     auto& [local, chunk] = args;
-    array<T> data(chunk.size() * local.commSize());
-    const int read = static_cast<int>(chunk.size());
-    MPI_Allgather(chunk.data(), read, get_mpi_type<T>(),
-            data.data(), read, get_mpi_type<T>(),
-            MPI_COMM_WORLD);
-   return data;
+    const trace::Span span("allGather", chunk.size() * sizeof(T), -1, get_mpi_type<T>());
+    array<T, A> data(chunk.size() * static_cast<size_t>(local.commSize()));
+    large::allGather(chunk.data(), chunk.size(), data.data(), chunk.size(), get_mpi_type<T>(), local.comm());
+    return data;
 }
 
-template<typename T>
-[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T>>
-allToAll(LocalProcess::out_op_args<T>&& args) {
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+allToAll(LocalProcess::out_op_args<T, A>&& args) {
     auto& [local, data] = args;
-    array<T> ret(data.size() * local.commSize());
-    const int read = static_cast<int>(data.size()) * sizeof(T);
-    MPI_Alltoall(data.data(), read, MPI_BYTE,
-           ret.data(), read, MPI_BYTE, MPI_COMM_WORLD);
+    const trace::Span span("allToAll", data.size() * sizeof(T), -1, MPI_BYTE);
+    array<T, A> ret(data.size() * static_cast<size_t>(local.commSize()));
+    large::allToAll(data.data(), ret.data(), data.size() * sizeof(T), MPI_BYTE, local.comm());
     return ret;
 }
 
-template<typename T>
-[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T>>
-allToAll(LocalProcess::out_op_args<T>&& args) {
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+allToAll(LocalProcess::out_op_args<T, A>&& args) {
     auto& [local, data] = args;
-    array<T> ret(data.size() * local.commSize());
-    MPI_Alltoall(data.data(), data.size(), get_mpi_type<T>(),
-            ret.data(), data.size(), get_mpi_type<T>(), MPI_COMM_WORLD);
+    const trace::Span span("allToAll", data.size() * sizeof(T), -1, get_mpi_type<T>());
+    array<T, A> ret(data.size() * static_cast<size_t>(local.commSize()));
+    large::allToAll(data.data(), ret.data(), data.size(), get_mpi_type<T>(), local.comm());
     return ret;
 }
 
 
-template<class T>
-[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T>>
-reduce(LocalProcess::arith_op_args<T>&& op) {
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+reduce(LocalProcess::arith_op_args<T, A>&& op) {
         auto& [local, src, mop] = op;
-        array<T> ret(src.size());
-        MPI_Reduce(src.data(), ret.data(), static_cast<int>(src.size() * sizeof(T)),
-            MPI_BYTE, mop, Process::ROOT, MPI_COMM_WORLD);
+        const trace::Span span("reduce", src.size() * sizeof(T), local.root(), MPI_BYTE);
+        array<T, A> ret(src.size());
+        large::reduce(src.data(), ret.data(), src.size() * sizeof(T),
+            MPI_BYTE, mop, local.root(), local.comm());
         return ret;
 }
 
 
-template<class T>
-[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T>>
-reduce(LocalProcess::arith_op_args<T>&& op) {
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+reduce(LocalProcess::arith_op_args<T, A>&& op) {
     auto& [local, src, mop] = op;
-    array<T> ret;
-    if (local.rank() == Process::ROOT) {
-        ret = array<T>(src.size());
+    const trace::Span span("reduce", src.size() * sizeof(T), local.root(), get_mpi_type<T>());
+    array<T, A> ret;
+    if (local.rank() == local.root()) {
+        ret = array<T, A>(src.size());
     }
-    MPI_Reduce(src.data(), ret.data(), static_cast<int>(src.size()),
-        get_mpi_type<T>(), mop, Process::ROOT, MPI_COMM_WORLD);
+    large::reduce(src.data(), ret.data(), src.size(),
+        get_mpi_type<T>(), mop, local.root(), local.comm());
     return ret;
 }
 
-template<class T>
-[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T>>
-allReduce(LocalProcess::arith_op_args<T>&& op) {
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+allReduce(LocalProcess::arith_op_args<T, A>&& op) {
     auto& [local, src, mop] = op;
-    array<T> ret(src.size());
-    MPI_Allreduce(src.data(), ret.data(), static_cast<int>(src.size() * sizeof(T)),
-        MPI_BYTE, mop, MPI_COMM_WORLD);
+    const trace::Span span("allReduce", src.size() * sizeof(T), -1, MPI_BYTE);
+    array<T, A> ret(src.size());
+    large::allReduce(src.data(), ret.data(), src.size() * sizeof(T),
+        MPI_BYTE, mop, local.comm());
     return ret;
 }
 
-template<class T>
-[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T>>
-allReduce(LocalProcess::arith_op_args<T>&& op) {
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+allReduce(LocalProcess::arith_op_args<T, A>&& op) {
     auto& [local, src, mop] = op;
-    array<T> ret(src.size());
-    MPI_Allreduce(src.data(), ret.data(), static_cast<int>(src.size()),
-        get_mpi_type<T>(), mop, MPI_COMM_WORLD);
+    const trace::Span span("allReduce", src.size() * sizeof(T), -1, get_mpi_type<T>());
+    array<T, A> ret(src.size());
+    large::allReduce(src.data(), ret.data(), src.size(),
+        get_mpi_type<T>(), mop, local.comm());
     return ret;
 }
 
-template<class T>
-[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T>>
-scan(LocalProcess::arith_op_args<T>&& op) {
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+scan(LocalProcess::arith_op_args<T, A>&& op) {
     auto& [local, src, mop] = op;
-    array<T> ret(src.size());
-    MPI_Scan(src.data(), src.data(), static_cast<int>(src.size() * sizeof(T)),
-        MPI_BYTE, mop, MPI_COMM_WORLD);
+    const trace::Span span("scan", src.size() * sizeof(T), -1, MPI_BYTE);
+    array<T, A> ret(src.size());
+    large::scan(src.data(), ret.data(), src.size() * sizeof(T),
+        MPI_BYTE, mop, local.comm());
     return ret;
 }
 
-template<class T>
-[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T>>
-scan(LocalProcess::arith_op_args<T>&& op) {
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+scan(LocalProcess::arith_op_args<T, A>&& op) {
     auto& [local, src, mop] = op;
-    array<T> ret(src.size());
-    MPI_Scan(src.data(), ret.data(), static_cast<int>(src.size()),
-        get_mpi_type<T>(), mop, MPI_COMM_WORLD);
+    const trace::Span span("scan", src.size() * sizeof(T), -1, get_mpi_type<T>());
+    array<T, A> ret(src.size());
+    large::scan(src.data(), ret.data(), src.size(),
+        get_mpi_type<T>(), mop, local.comm());
     return ret;
 }
 
-template<class T>
-[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T>>
-reduceScatter(LocalProcess::arith_op_args<T>&& op) {
-    auto& [local, src, mop] = op;
-    const auto commSize = static_cast<size_t>(local.commSize());
-    const array<int> count(commSize);
-    count.clear();
-    for (size_t i = 0; i < src.size(); i = (i + 1) % commSize) {
-        count[i] += sizeof(T);
+/// Element-wise reduce() of a lazy expression, e.g. reduce(*local + transform(std::move(chunk), f)).
+/// The mapped values are written straight into the send buffer, no intermediate array is made.
+template<typename E, typename Op>
+[[nodiscard]] array<expression_t<E>> reduce(LocalProcess::expr_op_args<E, Op>&& args) {
+    using U = expression_t<E>;
+    static_assert(is_builtin_mpi_type<U>::value, "reduce: expressions must evaluate to a builtin mpi type");
+    auto& [local, expr, op] = args;
+    const trace::Span span("reduce", expr.size() * sizeof(U), local.root(), get_mpi_type<U>());
+    array<U> src(expr.size());
+    evaluate(expr, src.data());
+    array<U> ret;
+    if (local.rank() == local.root()) {
+        ret = array<U>(src.size());
     }
-    array<T> ret(static_cast<size_t>(count[static_cast<size_t>(local.rank())]));
+    large::reduce(src.data(), ret.data(), src.size(), get_mpi_type<U>(), Op::op(), local.root(), local.comm());
+    return ret;
+}
+
+/// Element-wise allReduce() of a lazy expression
+template<typename E, typename Op>
+[[nodiscard]] array<expression_t<E>> allReduce(LocalProcess::expr_op_args<E, Op>&& args) {
+    using U = expression_t<E>;
+    static_assert(is_builtin_mpi_type<U>::value, "allReduce: expressions must evaluate to a builtin mpi type");
+    auto& [local, expr, op] = args;
+    const trace::Span span("allReduce", expr.size() * sizeof(U), -1, get_mpi_type<U>());
+    array<U> ret(expr.size());
+    evaluate(expr, ret.data());
+    large::allReduce(MPI_IN_PLACE, ret.data(), ret.size(), get_mpi_type<U>(), Op::op(), local.comm());
+    return ret;
+}
+
+/// Element-wise scan() of a lazy expression
+template<typename E, typename Op>
+[[nodiscard]] array<expression_t<E>> scan(LocalProcess::expr_op_args<E, Op>&& args) {
+    using U = expression_t<E>;
+    static_assert(is_builtin_mpi_type<U>::value, "scan: expressions must evaluate to a builtin mpi type");
+    auto& [local, expr, op] = args;
+    const trace::Span span("scan", expr.size() * sizeof(U), -1, get_mpi_type<U>());
+    array<U> ret(expr.size());
+    evaluate(expr, ret.data());
+    large::scan(MPI_IN_PLACE, ret.data(), ret.size(), get_mpi_type<U>(), Op::op(), local.comm());
+    return ret;
+}
+
+/// Reduces every element of the expression on every rank to one value on root, like
+/// std::transform_reduce. Mapping and local folding share one pass and only the folded value
+/// is sent. The value is only meaningful on root.
+template<typename E, typename Op>
+[[nodiscard]] expression_t<E> transformReduce(LocalProcess::expr_op_args<E, Op>&& args) {
+    using U = expression_t<E>;
+    static_assert(is_builtin_mpi_type<U>::value, "transformReduce: expressions must evaluate to a builtin mpi type");
+    auto& [local, expr, op] = args;
+    const trace::Span span("transformReduce", sizeof(U), local.root(), get_mpi_type<U>());
+    const U partial = fold(expr, op);
+    U result = partial;
+    MPI_Reduce(&partial, &result, 1, get_mpi_type<U>(), Op::op(), local.root(), local.comm());
+    return result;
+}
+
+/// transformReduce() with the value returned on every rank
+template<typename E, typename Op>
+[[nodiscard]] expression_t<E> transformAllReduce(LocalProcess::expr_op_args<E, Op>&& args) {
+    using U = expression_t<E>;
+    static_assert(is_builtin_mpi_type<U>::value, "transformAllReduce: expressions must evaluate to a builtin mpi type");
+    auto& [local, expr, op] = args;
+    const trace::Span span("transformAllReduce", sizeof(U), -1, get_mpi_type<U>());
+    U result = fold(expr, op);
+    MPI_Allreduce(MPI_IN_PLACE, &result, 1, get_mpi_type<U>(), Op::op(), local.comm());
+    return result;
+}
+
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+reduceScatter(LocalProcess::arith_op_args<T, A>&& op) {
+    auto& [local, src, mop] = op;
+    const trace::Span span("reduceScatter", src.size() * sizeof(T), -1, MPI_BYTE);
+    const array<int> count = balancedCounts(src.size(), static_cast<size_t>(local.commSize()), sizeof(T));
+    array<T, A> ret(static_cast<size_t>(count[static_cast<size_t>(local.rank())]) / sizeof(T));
     MPI_Reduce_scatter(src.data(), ret.data(),
-        count.data(), MPI_BYTE, mop, MPI_COMM_WORLD);
+        count.data(), MPI_BYTE, mop, local.comm());
     return ret;
 }
 
-template<class T>
-[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T>>
-reduceScatter(LocalProcess::arith_op_args<T>&& op) {
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+reduceScatter(LocalProcess::arith_op_args<T, A>&& op) {
     auto& [local, src, mop] = op;
+    const trace::Span span("reduceScatter", src.size() * sizeof(T), -1, get_mpi_type<T>());
+    const array<int> count = balancedCounts(src.size(), static_cast<size_t>(local.commSize()));
+    array<T, A> ret(static_cast<size_t>(count[static_cast<size_t>(local.rank())]));
+    MPI_Reduce_scatter(src.data(), ret.data(), count.data(), get_mpi_type<T>(),
+        mop, local.comm());
+    return ret;
+}
+
+/// allReduce() into the source buffer via MPI_IN_PLACE, pass an array_view to reduce into
+/// existing memory. Returns the buffer that now holds the result.
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+allReduceInPlace(LocalProcess::arith_op_args<T, A>&& op) {
+    auto& [local, buffer, mop] = op;
+    const trace::Span span("allReduceInPlace", buffer.size() * sizeof(T), -1, MPI_BYTE);
+    large::allReduce(MPI_IN_PLACE, buffer.data(), buffer.size() * sizeof(T),
+        MPI_BYTE, mop, local.comm());
+    return std::move(buffer);
+}
+
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+allReduceInPlace(LocalProcess::arith_op_args<T, A>&& op) {
+    auto& [local, buffer, mop] = op;
+    const trace::Span span("allReduceInPlace", buffer.size() * sizeof(T), -1, get_mpi_type<T>());
+    large::allReduce(MPI_IN_PLACE, buffer.data(), buffer.size(),
+        get_mpi_type<T>(), mop, local.comm());
+    return std::move(buffer);
+}
+
+/// reduce() into the source buffer of root via MPI_IN_PLACE. The buffer is returned on
+/// every rank but only holds the result on root.
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+reduceInPlace(LocalProcess::arith_op_args<T, A>&& op) {
+    auto& [local, buffer, mop] = op;
+    const trace::Span span("reduceInPlace", buffer.size() * sizeof(T), local.root(), MPI_BYTE);
+    const bool isRoot = local.rank() == local.root();
+    large::reduce(isRoot ? MPI_IN_PLACE : buffer.data(), isRoot ? buffer.data() : nullptr,
+        buffer.size() * sizeof(T), MPI_BYTE, mop, local.root(), local.comm());
+    return std::move(buffer);
+}
+
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+reduceInPlace(LocalProcess::arith_op_args<T, A>&& op) {
+    auto& [local, buffer, mop] = op;
+    const trace::Span span("reduceInPlace", buffer.size() * sizeof(T), local.root(), get_mpi_type<T>());
+    const bool isRoot = local.rank() == local.root();
+    large::reduce(isRoot ? MPI_IN_PLACE : buffer.data(), isRoot ? buffer.data() : nullptr,
+        buffer.size(), get_mpi_type<T>(), mop, local.root(), local.comm());
+    return std::move(buffer);
+}
+
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+scanInPlace(LocalProcess::arith_op_args<T, A>&& op) {
+    auto& [local, buffer, mop] = op;
+    const trace::Span span("scanInPlace", buffer.size() * sizeof(T), -1, MPI_BYTE);
+    large::scan(MPI_IN_PLACE, buffer.data(), buffer.size() * sizeof(T),
+        MPI_BYTE, mop, local.comm());
+    return std::move(buffer);
+}
+
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+scanInPlace(LocalProcess::arith_op_args<T, A>&& op) {
+    auto& [local, buffer, mop] = op;
+    const trace::Span span("scanInPlace", buffer.size() * sizeof(T), -1, get_mpi_type<T>());
+    large::scan(MPI_IN_PLACE, buffer.data(), buffer.size(),
+        get_mpi_type<T>(), mop, local.comm());
+    return std::move(buffer);
+}
 
+/// allGather() inside one buffer of commSize blocks, each rank's contribution already sits
+/// in its own block
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+allGatherInPlace(LocalProcess::out_op_args<T, A>&& args) {
+    auto& [local, buffer] = args;
+    const trace::Span span("allGatherInPlace", buffer.size() * sizeof(T), -1, MPI_BYTE);
+    const size_t read = buffer.size() / static_cast<size_t>(local.commSize()) * sizeof(T);
+    large::allGather(MPI_IN_PLACE, 0, buffer.data(), read, MPI_BYTE, local.comm());
+    return std::move(buffer);
+}
+
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+allGatherInPlace(LocalProcess::out_op_args<T, A>&& args) {
+    auto& [local, buffer] = args;
+    const trace::Span span("allGatherInPlace", buffer.size() * sizeof(T), -1, get_mpi_type<T>());
+    const size_t read = buffer.size() / static_cast<size_t>(local.commSize());
+    large::allGather(MPI_IN_PLACE, 0, buffer.data(), read, get_mpi_type<T>(), local.comm());
+    return std::move(buffer);
+}
+
+/// gather() into root's buffer of commSize blocks, root's own block is already in place.
+/// The other ranks pass just their chunk and get it back.
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+gatherInPlace(LocalProcess::out_op_args<T, A>&& args) {
+    auto& [local, buffer] = args;
+    const trace::Span span("gatherInPlace", buffer.size() * sizeof(T), local.root(), MPI_BYTE);
+    if (local.rank() == local.root()) {
+        const size_t read = buffer.size() / static_cast<size_t>(local.commSize()) * sizeof(T);
+        large::gather(MPI_IN_PLACE, 0, buffer.data(), read, MPI_BYTE, local.root(), local.comm());
+    } else {
+        large::gather(buffer.data(), buffer.size() * sizeof(T), nullptr, 0, MPI_BYTE,
+            local.root(), local.comm());
+    }
+    return std::move(buffer);
+}
+
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+gatherInPlace(LocalProcess::out_op_args<T, A>&& args) {
+    auto& [local, buffer] = args;
+    const trace::Span span("gatherInPlace", buffer.size() * sizeof(T), local.root(), get_mpi_type<T>());
+    if (local.rank() == local.root()) {
+        const size_t read = buffer.size() / static_cast<size_t>(local.commSize());
+        large::gather(MPI_IN_PLACE, 0, buffer.data(), read, get_mpi_type<T>(), local.root(), local.comm());
+    } else {
+        large::gather(buffer.data(), buffer.size(), nullptr, 0, get_mpi_type<T>(),
+            local.root(), local.comm());
+    }
+    return std::move(buffer);
+}
+
+/// Scatters exactly size elements (see LocalProcess::initv()) without padding. Chunks are
+/// balanced unless partition gives the element count of every rank.
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+scatterv(LocalProcess::in_op_args<T, A>&& args, const array<int>& partition = array<int>()) {
+    auto& [local, data, size] = args;
+    const trace::Span span("scatterv", size * sizeof(T), local.root(), MPI_BYTE);
     const auto commSize = static_cast<size_t>(local.commSize());
-    const array<int> count(commSize);
-    count.clear();
-    for (size_t i = 0; i < src.size(); i = (i + 1) % commSize) {
-        count[i] += 1;
+    if (!partition.empty()) {
+        checkPartition(partition, commSize, size);
     }
-    array<T> ret(static_cast<size_t>(count[static_cast<size_t>(local.rank())]));
-    MPI_Reduce_scatter(src.data(), ret.data(), count.data(), get_mpi_type<T>(),
-        mop, MPI_COMM_WORLD);
+    const array<int> count = partition.empty()
+        ? balancedCounts(size, commSize, sizeof(T)) : scaledCounts(partition, sizeof(T));
+    const array<int> displs = displacements(count);
+    const int read = count[static_cast<size_t>(local.rank())];
+    array<T, A> chunk(static_cast<size_t>(read) / sizeof(T));
+    MPI_Scatterv(data.data(), count.data(), displs.data(), MPI_BYTE,
+        chunk.data(), read, MPI_BYTE, local.root(), local.comm());
+    return chunk;
+}
+
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+scatterv(LocalProcess::in_op_args<T, A>&& args, const array<int>& partition = array<int>()) {
+    auto& [local, data, size] = args;
+    const trace::Span span("scatterv", size * sizeof(T), local.root(), get_mpi_type<T>());
+    const auto commSize = static_cast<size_t>(local.commSize());
+    if (!partition.empty()) {
+        checkPartition(partition, commSize, size);
+    }
+    const array<int> count = partition.empty()
+        ? balancedCounts(size, commSize) : scaledCounts(partition, 1);
+    const array<int> displs = displacements(count);
+    const int read = count[static_cast<size_t>(local.rank())];
+    array<T, A> chunk(static_cast<size_t>(read));
+    MPI_Scatterv(data.data(), count.data(), displs.data(), get_mpi_type<T>(),
+        chunk.data(), read, get_mpi_type<T>(), local.root(), local.comm());
+    return chunk;
+}
+
+/// Gathers chunks of any size on root, the result holds exactly their sum
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+gatherv(LocalProcess::out_op_args<T, A>&& args) {
+    auto& [local, chunk] = args;
+    const trace::Span span("gatherv", chunk.size() * sizeof(T), local.root(), MPI_BYTE);
+    const bool isRoot = local.rank() == local.root();
+    const int read = checkedCount(chunk.size() * sizeof(T));
+    array<int> count;
+    if (isRoot) {
+        count = array<int>(static_cast<size_t>(local.commSize()));
+    }
+    MPI_Gather(&read, 1, MPI_INT, count.data(), 1, MPI_INT, local.root(), local.comm());
+    array<int> displs;
+    array<T, A> data;
+    if (isRoot) {
+        displs = displacements(count);
+        data = array<T, A>(static_cast<size_t>(displs[count.size() - 1] + count[count.size() - 1]) / sizeof(T));
+    }
+    MPI_Gatherv(chunk.data(), read, MPI_BYTE,
+        data.data(), count.data(), displs.data(), MPI_BYTE,
+        local.root(), local.comm());
+    return data;
+}
+
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+gatherv(LocalProcess::out_op_args<T, A>&& args) {
+    auto& [local, chunk] = args;
+    const trace::Span span("gatherv", chunk.size() * sizeof(T), local.root(), get_mpi_type<T>());
+    const bool isRoot = local.rank() == local.root();
+    const int read = checkedCount(chunk.size());
+    array<int> count;
+    if (isRoot) {
+        count = array<int>(static_cast<size_t>(local.commSize()));
+    }
+    MPI_Gather(&read, 1, MPI_INT, count.data(), 1, MPI_INT, local.root(), local.comm());
+    array<int> displs;
+    array<T, A> data;
+    if (isRoot) {
+        displs = displacements(count);
+        data = array<T, A>(static_cast<size_t>(displs[count.size() - 1] + count[count.size() - 1]));
+    }
+    MPI_Gatherv(chunk.data(), read, get_mpi_type<T>(),
+        data.data(), count.data(), displs.data(), get_mpi_type<T>(),
+        local.root(), local.comm());
+    return data;
+}
+
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+allGatherv(LocalProcess::out_op_args<T, A>&& args) {
+    auto& [local, chunk] = args;
+    const trace::Span span("allGatherv", chunk.size() * sizeof(T), -1, MPI_BYTE);
+    const int read = checkedCount(chunk.size() * sizeof(T));
+    const array<int> count(static_cast<size_t>(local.commSize()));
+    MPI_Allgather(&read, 1, MPI_INT, count.data(), 1, MPI_INT, local.comm());
+    const array<int> displs = displacements(count);
+    array<T, A> data(static_cast<size_t>(displs[count.size() - 1] + count[count.size() - 1]) / sizeof(T));
+    MPI_Allgatherv(chunk.data(), read, MPI_BYTE,
+        data.data(), count.data(), displs.data(), MPI_BYTE, local.comm());
+    return data;
+}
+
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+allGatherv(LocalProcess::out_op_args<T, A>&& args) {
+    auto& [local, chunk] = args;
+    const trace::Span span("allGatherv", chunk.size() * sizeof(T), -1, get_mpi_type<T>());
+    const int read = checkedCount(chunk.size());
+    const array<int> count(static_cast<size_t>(local.commSize()));
+    MPI_Allgather(&read, 1, MPI_INT, count.data(), 1, MPI_INT, local.comm());
+    const array<int> displs = displacements(count);
+    array<T, A> data(static_cast<size_t>(displs[count.size() - 1] + count[count.size() - 1]));
+    MPI_Allgatherv(chunk.data(), read, get_mpi_type<T>(),
+        data.data(), count.data(), displs.data(), get_mpi_type<T>(), local.comm());
+    return data;
+}
+
+/// Sends partition[i] consecutive elements of data to rank i (balanced when omitted) and
+/// returns what every rank sent here, ordered by source rank
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+allToAllv(LocalProcess::out_op_args<T, A>&& args, const array<int>& partition = array<int>()) {
+    auto& [local, data] = args;
+    const trace::Span span("allToAllv", data.size() * sizeof(T), -1, MPI_BYTE);
+    const auto commSize = static_cast<size_t>(local.commSize());
+    if (!partition.empty()) {
+        checkPartition(partition, commSize, data.size());
+    }
+    const array<int> sendCount = partition.empty()
+        ? balancedCounts(data.size(), commSize, sizeof(T)) : scaledCounts(partition, sizeof(T));
+    const array<int> sendDispls = displacements(sendCount);
+    const array<int> recvCount(commSize);
+    MPI_Alltoall(sendCount.data(), 1, MPI_INT, recvCount.data(), 1, MPI_INT, local.comm());
+    const array<int> recvDispls = displacements(recvCount);
+    array<T, A> ret(static_cast<size_t>(recvDispls[commSize - 1] + recvCount[commSize - 1]) / sizeof(T));
+    MPI_Alltoallv(data.data(), sendCount.data(), sendDispls.data(), MPI_BYTE,
+        ret.data(), recvCount.data(), recvDispls.data(), MPI_BYTE, local.comm());
     return ret;
 }
 
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+allToAllv(LocalProcess::out_op_args<T, A>&& args, const array<int>& partition = array<int>()) {
+    auto& [local, data] = args;
+    const trace::Span span("allToAllv", data.size() * sizeof(T), -1, get_mpi_type<T>());
+    const auto commSize = static_cast<size_t>(local.commSize());
+    if (!partition.empty()) {
+        checkPartition(partition, commSize, data.size());
+    }
+    const array<int> sendCount = partition.empty()
+        ? balancedCounts(data.size(), commSize) : scaledCounts(partition, 1);
+    const array<int> sendDispls = displacements(sendCount);
+    const array<int> recvCount(commSize);
+    MPI_Alltoall(sendCount.data(), 1, MPI_INT, recvCount.data(), 1, MPI_INT, local.comm());
+    const array<int> recvDispls = displacements(recvCount);
+    array<T, A> ret(static_cast<size_t>(recvDispls[commSize - 1] + recvCount[commSize - 1]));
+    MPI_Alltoallv(data.data(), sendCount.data(), sendDispls.data(), get_mpi_type<T>(),
+        ret.data(), recvCount.data(), recvDispls.data(), get_mpi_type<T>(), local.comm());
+    return ret;
+}
+
+/// (indegree, outdegree) of the process topology attached to comm, for the neighbour
+/// collectives. Cartesian grids have two neighbours per dimension, MPI_PROC_NULL ones included.
+inline std::pair<int, int> neighborDegrees(MPI_Comm comm) {
+    int topology;
+    MPI_Topo_test(comm, &topology);
+    if (topology == MPI_DIST_GRAPH) {
+        int indegree;
+        int outdegree;
+        int weighted;
+        MPI_Dist_graph_neighbors_count(comm, &indegree, &outdegree, &weighted);
+        return {indegree, outdegree};
+    }
+    if (topology == MPI_CART) {
+        int ndims;
+        MPI_Cartdim_get(comm, &ndims);
+        return {2 * ndims, 2 * ndims};
+    }
+    if (topology == MPI_GRAPH) {
+        int rank;
+        int neighbors;
+        MPI_Comm_rank(comm, &rank);
+        MPI_Graph_neighbors_count(comm, rank, &neighbors);
+        return {neighbors, neighbors};
+    }
+    throw std::invalid_argument("neighbor collective on a communicator without topology");
+}
+
+/// Sends chunk to every destination of the topology and returns the chunks of all sources,
+/// in source order. Every rank must pass the same chunk size.
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+neighborAllGather(LocalProcess::out_op_args<T, A>&& args) {
+    auto& [local, chunk] = args;
+    const trace::Span span("neighborAllGather", chunk.size() * sizeof(T), -1, MPI_BYTE);
+    const auto [indegree, outdegree] = neighborDegrees(local.comm());
+    array<T, A> data(chunk.size() * static_cast<size_t>(indegree));
+    const int read = checkedCount(chunk.size() * sizeof(T));
+    MPI_Neighbor_allgather(chunk.data(), read, MPI_BYTE,
+        data.data(), read, MPI_BYTE, local.comm());
+    return data;
+}
+
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+neighborAllGather(LocalProcess::out_op_args<T, A>&& args) {
+    auto& [local, chunk] = args;
+    const trace::Span span("neighborAllGather", chunk.size() * sizeof(T), -1, get_mpi_type<T>());
+    const auto [indegree, outdegree] = neighborDegrees(local.comm());
+    array<T, A> data(chunk.size() * static_cast<size_t>(indegree));
+    const int read = checkedCount(chunk.size());
+    MPI_Neighbor_allgather(chunk.data(), read, get_mpi_type<T>(),
+        data.data(), read, get_mpi_type<T>(), local.comm());
+    return data;
+}
+
+/// Sends the i-th of outdegree equal blocks of data to destination i and returns one block per
+/// source, in source order
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+neighborAllToAll(LocalProcess::out_op_args<T, A>&& args) {
+    auto& [local, data] = args;
+    const trace::Span span("neighborAllToAll", data.size() * sizeof(T), -1, MPI_BYTE);
+    const auto [indegree, outdegree] = neighborDegrees(local.comm());
+    const size_t block = outdegree == 0 ? 0 : data.size() / static_cast<size_t>(outdegree);
+    array<T, A> ret(block * static_cast<size_t>(indegree));
+    const int read = checkedCount(block * sizeof(T));
+    MPI_Neighbor_alltoall(data.data(), read, MPI_BYTE,
+        ret.data(), read, MPI_BYTE, local.comm());
+    return ret;
+}
+
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+neighborAllToAll(LocalProcess::out_op_args<T, A>&& args) {
+    auto& [local, data] = args;
+    const trace::Span span("neighborAllToAll", data.size() * sizeof(T), -1, get_mpi_type<T>());
+    const auto [indegree, outdegree] = neighborDegrees(local.comm());
+    const size_t block = outdegree == 0 ? 0 : data.size() / static_cast<size_t>(outdegree);
+    array<T, A> ret(block * static_cast<size_t>(indegree));
+    const int read = checkedCount(block);
+    MPI_Neighbor_alltoall(data.data(), read, get_mpi_type<T>(),
+        ret.data(), read, get_mpi_type<T>(), local.comm());
+    return ret;
+}
+
+/// Sends partition[i] consecutive elements of data to destination i and returns what every
+/// source sent here, in source order. The counts travel first with a neighbour allToAll.
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, array<T, A>>
+neighborAllToAllv(LocalProcess::out_op_args<T, A>&& args, const array<int>& partition) {
+    auto& [local, data] = args;
+    const trace::Span span("neighborAllToAllv", data.size() * sizeof(T), -1, MPI_BYTE);
+    const auto [indegree, outdegree] = neighborDegrees(local.comm());
+    checkPartition(partition, static_cast<size_t>(outdegree), data.size());
+    const array<int> sendCount = scaledCounts(partition, sizeof(T));
+    const array<int> sendDispls = displacements(sendCount);
+    const array<int> recvCount(static_cast<size_t>(indegree));
+    MPI_Neighbor_alltoall(sendCount.data(), 1, MPI_INT, recvCount.data(), 1, MPI_INT, local.comm());
+    const array<int> recvDispls = displacements(recvCount);
+    const size_t bytes = indegree == 0 ? 0
+        : static_cast<size_t>(recvDispls[recvCount.size() - 1]) + static_cast<size_t>(recvCount[recvCount.size() - 1]);
+    array<T, A> ret(bytes / sizeof(T));
+    MPI_Neighbor_alltoallv(data.data(), sendCount.data(), sendDispls.data(), MPI_BYTE,
+        ret.data(), recvCount.data(), recvDispls.data(), MPI_BYTE, local.comm());
+    return ret;
+}
+
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, array<T, A>>
+neighborAllToAllv(LocalProcess::out_op_args<T, A>&& args, const array<int>& partition) {
+    auto& [local, data] = args;
+    const trace::Span span("neighborAllToAllv", data.size() * sizeof(T), -1, get_mpi_type<T>());
+    const auto [indegree, outdegree] = neighborDegrees(local.comm());
+    checkPartition(partition, static_cast<size_t>(outdegree), data.size());
+    const array<int> sendDispls = displacements(partition);
+    const array<int> recvCount(static_cast<size_t>(indegree));
+    MPI_Neighbor_alltoall(partition.data(), 1, MPI_INT, recvCount.data(), 1, MPI_INT, local.comm());
+    const array<int> recvDispls = displacements(recvCount);
+    const size_t size = indegree == 0 ? 0
+        : static_cast<size_t>(recvDispls[recvCount.size() - 1]) + static_cast<size_t>(recvCount[recvCount.size() - 1]);
+    array<T, A> ret(size);
+    MPI_Neighbor_alltoallv(data.data(), partition.data(), sendDispls.data(), get_mpi_type<T>(),
+        ret.data(), recvCount.data(), recvDispls.data(), get_mpi_type<T>(), local.comm());
+    return ret;
+}
+
+/// Non-blocking scatter(), the Future yields the local chunk
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, Future<T, A>>
+iscatter(LocalProcess::in_op_args<T, A>&& args) {
+    auto& [local, data, size] = args;
+    const trace::Span span("iscatter", size * sizeof(T), local.root(), MPI_BYTE);
+    const size_t chunkSize = size / static_cast<size_t>(local.commSize());
+    Future<T, A> future(std::move(data), array<T, A>(chunkSize));
+    large::iscatter(future.src().data(), future.result().data(), chunkSize * sizeof(T), MPI_BYTE,
+        local.root(), local.comm(), future.request());
+    return future;
+}
+
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, Future<T, A>>
+iscatter(LocalProcess::in_op_args<T, A>&& args) {
+    auto& [local, data, size] = args;
+    const trace::Span span("iscatter", size * sizeof(T), local.root(), get_mpi_type<T>());
+    const size_t chunkSize = size / static_cast<size_t>(local.commSize());
+    Future<T, A> future(std::move(data), array<T, A>(chunkSize));
+    large::iscatter(future.src().data(), future.result().data(), chunkSize, get_mpi_type<T>(),
+        local.root(), local.comm(), future.request());
+    return future;
+}
+
+/// Non-blocking broadcast(), the Future yields the broadcast data on every rank
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, Future<T, A>>
+ibroadcast(LocalProcess::in_op_args<T, A>&& args) {
+    auto& [local, data, size] = args;
+    const trace::Span span("ibroadcast", size * sizeof(T), local.root(), MPI_BYTE);
+    if (local.rank() != local.root()) {
+        data = array<T, A>(size);
+    }
+    Future<T, A> future(array<T, A>(), std::move(data));
+    large::ibcast(future.result().data(), size * sizeof(T), MPI_BYTE,
+        local.root(), local.comm(), future.request());
+    return future;
+}
+
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, Future<T, A>>
+ibroadcast(LocalProcess::in_op_args<T, A>&& args) {
+    auto& [local, data, size] = args;
+    const trace::Span span("ibroadcast", size * sizeof(T), local.root(), get_mpi_type<T>());
+    if (local.rank() != local.root()) {
+        data = array<T, A>(size);
+    }
+    Future<T, A> future(array<T, A>(), std::move(data));
+    large::ibcast(future.result().data(), size, get_mpi_type<T>(),
+        local.root(), local.comm(), future.request());
+    return future;
+}
+
+/// Non-blocking gather(), the Future yields the gathered data on root and an empty array elsewhere
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, Future<T, A>>
+igather(LocalProcess::out_op_args<T, A>&& args) {
+    auto& [local, chunk] = args;
+    const trace::Span span("igather", chunk.size() * sizeof(T), local.root(), MPI_BYTE);
+    array<T, A> data;
+    if (local.rank() == local.root()) {
+        data = array<T, A>(chunk.size() * static_cast<size_t>(local.commSize()));
+    }
+    const size_t read = chunk.size() * sizeof(T);
+    Future<T, A> future(std::move(chunk), std::move(data));
+    large::igather(future.src().data(), future.result().data(), read, MPI_BYTE,
+        local.root(), local.comm(), future.request());
+    return future;
+}
+
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, Future<T, A>>
+igather(LocalProcess::out_op_args<T, A>&& args) {
+    auto& [local, chunk] = args;
+    const trace::Span span("igather", chunk.size() * sizeof(T), local.root(), get_mpi_type<T>());
+    array<T, A> data;
+    if (local.rank() == local.root()) {
+        data = array<T, A>(chunk.size() * static_cast<size_t>(local.commSize()));
+    }
+    const size_t read = chunk.size();
+    Future<T, A> future(std::move(chunk), std::move(data));
+    large::igather(future.src().data(), future.result().data(), read, get_mpi_type<T>(),
+        local.root(), local.comm(), future.request());
+    return future;
+}
+
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, Future<T, A>>
+iallGather(LocalProcess::out_op_args<T, A>&& args) {
+    auto& [local, chunk] = args;
+    const trace::Span span("iallGather", chunk.size() * sizeof(T), -1, MPI_BYTE);
+    const size_t read = chunk.size() * sizeof(T);
+    array<T, A> data(chunk.size() * static_cast<size_t>(local.commSize()));
+    Future<T, A> future(std::move(chunk), std::move(data));
+    large::iallGather(future.src().data(), future.result().data(), read, MPI_BYTE,
+        local.comm(), future.request());
+    return future;
+}
+
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, Future<T, A>>
+iallGather(LocalProcess::out_op_args<T, A>&& args) {
+    auto& [local, chunk] = args;
+    const trace::Span span("iallGather", chunk.size() * sizeof(T), -1, get_mpi_type<T>());
+    const size_t read = chunk.size();
+    array<T, A> data(chunk.size() * static_cast<size_t>(local.commSize()));
+    Future<T, A> future(std::move(chunk), std::move(data));
+    large::iallGather(future.src().data(), future.result().data(), read, get_mpi_type<T>(),
+        local.comm(), future.request());
+    return future;
+}
+
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, Future<T, A>>
+iallToAll(LocalProcess::out_op_args<T, A>&& args) {
+    auto& [local, data] = args;
+    const trace::Span span("iallToAll", data.size() * sizeof(T), -1, MPI_BYTE);
+    const size_t read = data.size() * sizeof(T);
+    array<T, A> ret(data.size() * static_cast<size_t>(local.commSize()));
+    Future<T, A> future(std::move(data), std::move(ret));
+    large::iallToAll(future.src().data(), future.result().data(), read, MPI_BYTE,
+        local.comm(), future.request());
+    return future;
+}
+
+template<typename T, typename A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, Future<T, A>>
+iallToAll(LocalProcess::out_op_args<T, A>&& args) {
+    auto& [local, data] = args;
+    const trace::Span span("iallToAll", data.size() * sizeof(T), -1, get_mpi_type<T>());
+    const size_t read = data.size();
+    array<T, A> ret(data.size() * static_cast<size_t>(local.commSize()));
+    Future<T, A> future(std::move(data), std::move(ret));
+    large::iallToAll(future.src().data(), future.result().data(), read, get_mpi_type<T>(),
+        local.comm(), future.request());
+    return future;
+}
+
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, Future<T, A>>
+ireduce(LocalProcess::arith_op_args<T, A>&& op) {
+    auto& [local, src, mop] = op;
+    const trace::Span span("ireduce", src.size() * sizeof(T), local.root(), MPI_BYTE);
+    const int read = checkedCount(src.size() * sizeof(T));
+    array<T, A> ret;
+    if (local.rank() == local.root()) {
+        ret = array<T, A>(src.size());
+    }
+    Future<T, A> future(std::move(src), std::move(ret));
+    MPI_Ireduce(future.src().data(), future.result().data(), read,
+        MPI_BYTE, mop, local.root(), local.comm(), future.request());
+    return future;
+}
+
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, Future<T, A>>
+ireduce(LocalProcess::arith_op_args<T, A>&& op) {
+    auto& [local, src, mop] = op;
+    const trace::Span span("ireduce", src.size() * sizeof(T), local.root(), get_mpi_type<T>());
+    const int read = checkedCount(src.size());
+    array<T, A> ret;
+    if (local.rank() == local.root()) {
+        ret = array<T, A>(src.size());
+    }
+    Future<T, A> future(std::move(src), std::move(ret));
+    MPI_Ireduce(future.src().data(), future.result().data(), read,
+        get_mpi_type<T>(), mop, local.root(), local.comm(), future.request());
+    return future;
+}
+
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, Future<T, A>>
+iallReduce(LocalProcess::arith_op_args<T, A>&& op) {
+    auto& [local, src, mop] = op;
+    const trace::Span span("iallReduce", src.size() * sizeof(T), -1, MPI_BYTE);
+    const int read = checkedCount(src.size() * sizeof(T));
+    array<T, A> ret(src.size());
+    Future<T, A> future(std::move(src), std::move(ret));
+    MPI_Iallreduce(future.src().data(), future.result().data(), read,
+        MPI_BYTE, mop, local.comm(), future.request());
+    return future;
+}
+
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, Future<T, A>>
+iallReduce(LocalProcess::arith_op_args<T, A>&& op) {
+    auto& [local, src, mop] = op;
+    const trace::Span span("iallReduce", src.size() * sizeof(T), -1, get_mpi_type<T>());
+    const int read = checkedCount(src.size());
+    array<T, A> ret(src.size());
+    Future<T, A> future(std::move(src), std::move(ret));
+    MPI_Iallreduce(future.src().data(), future.result().data(), read,
+        get_mpi_type<T>(), mop, local.comm(), future.request());
+    return future;
+}
+
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, Future<T, A>>
+iscan(LocalProcess::arith_op_args<T, A>&& op) {
+    auto& [local, src, mop] = op;
+    const trace::Span span("iscan", src.size() * sizeof(T), -1, MPI_BYTE);
+    const int read = checkedCount(src.size() * sizeof(T));
+    array<T, A> ret(src.size());
+    Future<T, A> future(std::move(src), std::move(ret));
+    MPI_Iscan(future.src().data(), future.result().data(), read,
+        MPI_BYTE, mop, local.comm(), future.request());
+    return future;
+}
+
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, Future<T, A>>
+iscan(LocalProcess::arith_op_args<T, A>&& op) {
+    auto& [local, src, mop] = op;
+    const trace::Span span("iscan", src.size() * sizeof(T), -1, get_mpi_type<T>());
+    const int read = checkedCount(src.size());
+    array<T, A> ret(src.size());
+    Future<T, A> future(std::move(src), std::move(ret));
+    MPI_Iscan(future.src().data(), future.result().data(), read,
+        get_mpi_type<T>(), mop, local.comm(), future.request());
+    return future;
+}
+
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, Future<T, A>>
+ireduceScatter(LocalProcess::arith_op_args<T, A>&& op) {
+    auto& [local, src, mop] = op;
+    const trace::Span span("ireduceScatter", src.size() * sizeof(T), -1, MPI_BYTE);
+    array<int> count = balancedCounts(src.size(), static_cast<size_t>(local.commSize()), sizeof(T));
+    array<T, A> ret(static_cast<size_t>(count[static_cast<size_t>(local.rank())]) / sizeof(T));
+    Future<T, A> future(std::move(src), std::move(ret), std::move(count));
+    MPI_Ireduce_scatter(future.src().data(), future.result().data(),
+        future.counts().data(), MPI_BYTE, mop, local.comm(), future.request());
+    return future;
+}
+
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, Future<T, A>>
+ireduceScatter(LocalProcess::arith_op_args<T, A>&& op) {
+    auto& [local, src, mop] = op;
+    const trace::Span span("ireduceScatter", src.size() * sizeof(T), -1, get_mpi_type<T>());
+    array<int> count = balancedCounts(src.size(), static_cast<size_t>(local.commSize()));
+    array<T, A> ret(static_cast<size_t>(count[static_cast<size_t>(local.rank())]));
+    Future<T, A> future(std::move(src), std::move(ret), std::move(count));
+    MPI_Ireduce_scatter(future.src().data(), future.result().data(),
+        future.counts().data(), get_mpi_type<T>(), mop, local.comm(), future.request());
+    return future;
+}
+
+/// Persistent allReduce() over a fixed-size buffer, refill plan.src() before every start().
+/// Uses MPI_Allreduce_init on MPI-4 libraries and re-issues MPI_Iallreduce otherwise.
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<!is_mpi_type<T>::value, Plan<T, A>>
+allReducePlan(LocalProcess::arith_op_args<T, A>&& op) {
+    auto& [local, src, mop] = op;
+    const trace::Span span("allReducePlan", src.size() * sizeof(T), -1, MPI_BYTE);
+    const int read = checkedCount(src.size() * sizeof(T));
+    array<T, A> ret(src.size());
+#if MPI_VERSION >= 4
+    Plan<T, A> plan(std::move(src), std::move(ret));
+    MPI_Allreduce_init(plan.src().data(), plan.result().data(), read,
+        MPI_BYTE, mop, local.comm(), MPI_INFO_NULL, plan.request());
+    return plan;
+#else
+    return Plan<T, A>(std::move(src), std::move(ret),
+        [read, mop, comm = local.comm()](const array<T, A>& in, const array<T, A>& out, MPI_Request* request) {
+            MPI_Iallreduce(in.data(), out.data(), read, MPI_BYTE, mop, comm, request);
+        });
+#endif
+}
+
+template<class T, class A>
+[[nodiscard]] std::enable_if_t<is_mpi_type<T>::value, Plan<T, A>>
+allReducePlan(LocalProcess::arith_op_args<T, A>&& op) {
+    auto& [local, src, mop] = op;
+    const trace::Span span("allReducePlan", src.size() * sizeof(T), -1, get_mpi_type<T>());
+    const int read = checkedCount(src.size());
+    array<T, A> ret(src.size());
+#if MPI_VERSION >= 4
+    Plan<T, A> plan(std::move(src), std::move(ret));
+    MPI_Allreduce_init(plan.src().data(), plan.result().data(), read,
+        get_mpi_type<T>(), mop, local.comm(), MPI_INFO_NULL, plan.request());
+    return plan;
+#else
+    return Plan<T, A>(std::move(src), std::move(ret),
+        [read, mop, type = get_mpi_type<T>(), comm = local.comm()]
+        (const array<T, A>& in, const array<T, A>& out, MPI_Request* request) {
+            MPI_Iallreduce(in.data(), out.data(), read, type, mop, comm, request);
+        });
+#endif
+}
+
 }
 
 #endif //OPERATIONS_H
@@ -0,0 +1,119 @@
+#ifndef PLAN_H
+#define PLAN_H
+
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <mpi.h>
+#include <array.h>
+
+
+
+namespace mpi {
+
+/// Communication bound once to its buffers, peer/op and communicator and restarted every
+/// iteration with start()/wait(). The src/result arrays are reused, refill them in place.
+template<typename T, typename A = new_allocator<T>>
+class Plan {
+public:
+
+    /// Re-issues a non-blocking call for operations without a persistent MPI counterpart
+    using Starter = std::function<void(const array<T, A>& src, const array<T, A>& result, MPI_Request* request)>;
+
+    /// The request must be initialized with a persistent MPI_*_init call
+    explicit Plan(array<T, A>&& src, array<T, A>&& result)
+        : src_(std::move(src)), result_(std::move(result)) {}
+
+    explicit Plan(array<T, A>&& src, array<T, A>&& result, Starter&& starter)
+        : src_(std::move(src)), result_(std::move(result)), starter_(std::move(starter)) {}
+
+    Plan(const Plan& other) = delete;
+
+    Plan(Plan&& other) noexcept
+        : src_(std::move(other.src_)), result_(std::move(other.result_)), starter_(std::move(other.starter_)),
+          request_(std::exchange(other.request_, MPI_REQUEST_NULL)), active_(std::exchange(other.active_, false)) {}
+
+    Plan& operator=(const Plan& other) = delete;
+
+    /// Completes and frees the request of this plan before its buffers are replaced
+    Plan& operator=(Plan&& other) noexcept {
+        if (this != &other) {
+            release();
+            src_ = std::move(other.src_);
+            result_ = std::move(other.result_);
+            starter_ = std::move(other.starter_);
+            request_ = std::exchange(other.request_, MPI_REQUEST_NULL);
+            active_ = std::exchange(other.active_, false);
+        }
+        return *this;
+    }
+
+    ~Plan() {
+        release();
+    }
+
+    void start() {
+        if (active_) {
+            throw std::logic_error("Plan::start");
+        }
+        if (starter_) {
+            starter_(src_, result_, &request_);
+        } else {
+            MPI_Start(&request_);
+        }
+        active_ = true;
+    }
+
+    void wait() {
+        if (active_) {
+            MPI_Wait(&request_, MPI_STATUS_IGNORE);
+            active_ = false;
+        }
+    }
+
+    /// Starts and completes one iteration
+    void operator()() {
+        start();
+        wait();
+    }
+
+    /// The request lives inside the Plan, the pointer is invalidated by moving it
+    [[nodiscard]] MPI_Request* request() const { return &request_; }
+
+    [[nodiscard]] const array<T, A>& src() const { return src_; }
+
+    [[nodiscard]] const array<T, A>& result() const { return result_; }
+
+private:
+
+    /// Waits for an active iteration and frees a persistent request
+    void release() noexcept {
+        int finalized = 0;
+        MPI_Finalized(&finalized);
+        if (finalized) {
+            return;
+        }
+        if (active_) {
+            MPI_Wait(&request_, MPI_STATUS_IGNORE);
+            active_ = false;
+        }
+        if (!starter_ && request_ != MPI_REQUEST_NULL) {
+            MPI_Request_free(&request_);
+        }
+    }
+
+    array<T, A> src_;
+
+    array<T, A> result_;
+
+    Starter starter_;
+
+    mutable MPI_Request request_ = MPI_REQUEST_NULL;
+
+    bool active_ = false;
+
+};
+
+}
+
+#endif //PLAN_H
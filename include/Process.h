@@ -1,6 +1,10 @@
 #ifndef PROCESS_H
 #define PROCESS_H
 
+#include <memory>
+#include <mpi.h>
+#include <Communicator.h>
+
 
 
 namespace mpi {
@@ -8,9 +12,8 @@ namespace mpi {
 class Process {
 public:
 
-    static int ROOT;
-
-    explicit Process(const int rank, const int commSize) : rank_(rank), commSize_(commSize) {}
+    explicit Process(std::shared_ptr<Communicator> comm, const int rank)
+        : comm_(std::move(comm)), rank_(rank), commSize_(comm_->size()) {}
 
     explicit Process(const Process& other) = delete;
 
@@ -24,9 +27,18 @@ public:
 
     [[nodiscard]] int commSize() const;
 
+    /// Root rank of the communicator this process belongs to
+    [[nodiscard]] int root() const;
+
+    [[nodiscard]] MPI_Comm comm() const;
+
+    [[nodiscard]] const std::shared_ptr<Communicator>& communicator() const;
+
 protected:
 
-    int rank_;  // MPI rank
+    std::shared_ptr<Communicator> comm_;
+
+    int rank_;  // MPI rank within comm_
 
     int commSize_;
 
@@ -0,0 +1,53 @@
+#ifndef PROGRESSTHREAD_H
+#define PROGRESSTHREAD_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <Communicator.h>
+
+
+
+namespace mpi {
+
+/// Background thread that keeps polling the MPI progress engine, so non-blocking transfers
+/// advance while the rank computes instead of only inside the next MPI_Wait. It probes a
+/// private duplicate of the communicator, hence never matches application messages.
+/// Requires MPI_THREAD_MULTIPLE.
+class ProgressThread {
+public:
+
+    /// Construction duplicates comm and is therefore collective
+    explicit ProgressThread(const Communicator& comm,
+                            std::chrono::microseconds interval = std::chrono::microseconds(20));
+
+    ProgressThread(const ProgressThread& other) = delete;
+
+    ProgressThread& operator=(const ProgressThread& other) = delete;
+
+    /// Stops and joins the thread
+    ~ProgressThread();
+
+    /// Number of polls so far
+    [[nodiscard]] size_t polls() const;
+
+private:
+
+    void run() const;
+
+    std::shared_ptr<Communicator> comm_;
+
+    std::chrono::microseconds interval_;
+
+    std::atomic<bool> stop_ = false;
+
+    mutable std::atomic<size_t> polls_ = 0;
+
+    std::thread thread_;
+
+};
+
+}
+
+#endif //PROGRESSTHREAD_H
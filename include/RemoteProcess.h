@@ -1,8 +1,17 @@
 #ifndef REMOTEPROCESS_H
 #define REMOTEPROCESS_H
 
+#include <memory>
+#include <utility>
 #include <mpi.h>
+#include <Message.h>
+#include <Plan.h>
 #include <Process.h>
+#include <Trace.h>
+#include <array.h>
+#include <array_view.h>
+#include <large_count.h>
+#include <mpi_types.h>
 
 
 
@@ -11,171 +20,319 @@ namespace mpi {
 class RemoteProcess final : public Process {
 public:
 
+    /// Owns a posted request by value, MPI_Request is a handle and may be moved freely
     class Awaitable {
     public:
 
-        explicit Awaitable(std::unique_ptr<MPI_Request>&& request)
-            : request_(std::move(request)) {}
+        explicit Awaitable(MPI_Request request) : request_(request) {}
+
+        Awaitable(const Awaitable& other) = delete;
+
+        Awaitable(Awaitable&& other) noexcept
+            : request_(std::exchange(other.request_, MPI_REQUEST_NULL)) {}
+
+        Awaitable& operator=(const Awaitable& other) = delete;
+
+        /// Completes the request held so far before taking over the one of other
+        Awaitable& operator=(Awaitable&& other) noexcept {
+            if (this != &other) {
+                complete();
+                request_ = std::exchange(other.request_, MPI_REQUEST_NULL);
+            }
+            return *this;
+        }
+
+        /// A request still pending is waited for, its buffers may be released right after
+        ~Awaitable() {
+            complete();
+        }
 
         void operator()() const {
-            MPI_Wait(request_.get(), MPI_STATUS_IGNORE);
+            const trace::Span span("wait", 0, -1, MPI_DATATYPE_NULL);
+            MPI_Wait(&request_, MPI_STATUS_IGNORE);
+        }
+
+        /// Returns true once the request has completed, without blocking
+        [[nodiscard]] bool test() const {
+            int flag = 0;
+            MPI_Test(&request_, &flag, MPI_STATUS_IGNORE);
+            return flag != 0;
+        }
+
+        /// Hands the request over, e.g. to a RequestSet
+        [[nodiscard]] MPI_Request release() {
+            return std::exchange(request_, MPI_REQUEST_NULL);
         }
 
     private:
 
-        std::unique_ptr<MPI_Request> request_ = nullptr;
+        void complete() noexcept {
+            int finalized = 0;
+            MPI_Finalized(&finalized);
+            if (request_ != MPI_REQUEST_NULL && !finalized) {
+                MPI_Wait(&request_, MPI_STATUS_IGNORE);
+            }
+        }
+
+        mutable MPI_Request request_ = MPI_REQUEST_NULL;
 
     };
 
     class SyncFunctor {
     public:
 
-        explicit SyncFunctor(const int rank) : rank_(rank) {}
+        explicit SyncFunctor(const int rank, MPI_Comm comm, const int tag = 0)
+            : rank_(rank), comm_(comm), tag_(tag) {}
 
         template<typename T>
         std::enable_if_t<!is_mpi_type<T>::value, void>
         operator<<(const T& data) {
-            MPI_Send(&data, sizeof(T), MPI_BYTE, rank_, 0, MPI_COMM_WORLD);
+            const trace::Span span("send", sizeof(T), rank_, MPI_BYTE);
+            MPI_Send(&data, static_cast<int>(sizeof(T)), MPI_BYTE, rank_, tag_, comm_);
         }
 
         template<typename T>
         std::enable_if_t<is_mpi_type<T>::value, void>
         operator<<(const T& data) {
-            MPI_Send(&data, 1, get_mpi_type<T>(), rank_, 0,
-                MPI_COMM_WORLD);
+            const trace::Span span("send", sizeof(T), rank_, get_mpi_type<T>());
+            MPI_Send(&data, 1, get_mpi_type<T>(), rank_, tag_,
+                comm_);
         }
 
         template <typename T>
-        std::enable_if_t<!is_mpi_type<T>::value, void>
-        operator>>(const T& data) {
-            MPI_Recv(&data, sizeof(T), MPI_BYTE, rank_, 0,
-                MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        std::enable_if_t<!is_mpi_type<T>::value && !is_mpi_array<std::remove_cv_t<T>>::value, void>
+        operator>>(T& data) {
+            const trace::Span span("recv", sizeof(T), rank_, MPI_BYTE);
+            MPI_Recv(&data, static_cast<int>(sizeof(T)), MPI_BYTE, rank_, tag_,
+                comm_, MPI_STATUS_IGNORE);
         }
 
         template <typename T>
         std::enable_if_t<is_mpi_type<T>::value, void>
-        operator>>(const T& data) {
-            MPI_Recv(&data, 1, get_mpi_type<T>(), rank_, 0,
-                MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        operator>>(T& data) {
+            const trace::Span span("recv", sizeof(T), rank_, get_mpi_type<T>());
+            MPI_Recv(&data, 1, get_mpi_type<T>(), rank_, tag_,
+                comm_, MPI_STATUS_IGNORE);
         }
 
-        template<typename T>
+        template<typename T, typename A>
         std::enable_if_t<!is_mpi_type<T>::value, void>
-        operator<<(const array<T>& data) {
-            MPI_Send(data.data(), static_cast<int>(data.size() * sizeof(T)),
-                MPI_BYTE, rank_, 0, MPI_COMM_WORLD);
+        operator<<(const array<T, A>& data) {
+            const trace::Span span("send", data.size() * sizeof(T), rank_, MPI_BYTE);
+            large::send(data.data(), data.size() * sizeof(T),
+                MPI_BYTE, rank_, tag_, comm_);
         }
 
-        template<typename T>
+        template<typename T, typename A>
         std::enable_if_t<is_mpi_type<T>::value, void>
-        operator<<(const array<T>& data) {
-            MPI_Send(data.data(), static_cast<int>(data.size()),
-                get_mpi_type<T>(), rank_, 0, MPI_COMM_WORLD);
+        operator<<(const array<T, A>& data) {
+            const trace::Span span("send", data.size() * sizeof(T), rank_, get_mpi_type<T>());
+            large::send(data.data(), data.size(),
+                get_mpi_type<T>(), rank_, tag_, comm_);
         }
 
-        template <typename T>
+        template <typename T, typename A>
         std::enable_if_t<!is_mpi_type<T>::value, void>
-        operator>>(const array<T>& data) {
-            MPI_Recv(data.data(), static_cast<int>(data.size()) * sizeof(T),
-                MPI_BYTE, rank_, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        operator>>(const array<T, A>& data) {
+            const trace::Span span("recv", data.size() * sizeof(T), rank_, MPI_BYTE);
+            large::recv(data.data(), data.size() * sizeof(T),
+                MPI_BYTE, rank_, tag_, comm_);
         }
 
-        template <typename T>
+        template <typename T, typename A>
         std::enable_if_t<is_mpi_type<T>::value, void>
-        operator>>(const array<T>& data) {
-            MPI_Recv(data.data(), static_cast<int>(data.size()),
-                get_mpi_type<T>(), rank_, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        operator>>(const array<T, A>& data) {
+            const trace::Span span("recv", data.size() * sizeof(T), rank_, get_mpi_type<T>());
+            large::recv(data.data(), data.size(),
+                get_mpi_type<T>(), rank_, tag_, comm_);
+        }
+
+        /// Receives a message of unknown size, the returned array is sized from its envelope
+        template<typename T, typename A = new_allocator<T>>
+        [[nodiscard]] array<T, A> receive() {
+            return mpi::receive<T, A>(rank_, tag_, comm_).data;
+        }
+
+        template<typename T>
+        void operator<<(const array_view<T>& data) {
+            *this << static_cast<const array<T>&>(data);
+        }
+
+        template <typename T>
+        void operator>>(const array_view<T>& data) {
+            *this >> static_cast<const array<T>&>(data);
         }
 
     private:
 
         int rank_;
 
+        MPI_Comm comm_;
+
+        int tag_;
+
     };
 
     class AsyncFunctor {
     public:
-        explicit AsyncFunctor(const int rank) : rank_(rank) {}
+        explicit AsyncFunctor(const int rank, MPI_Comm comm, const int tag = 0)
+            : rank_(rank), comm_(comm), tag_(tag) {}
 
         template<typename T>
         std::enable_if_t<!is_mpi_type<T>::value, Awaitable>
         operator<<(const T& data) {
-            auto request = std::make_unique<MPI_Request>();
-            MPI_Isend(&data, sizeof(T), MPI_BYTE, rank_, 0,
-                MPI_COMM_WORLD, request.get());
-            return Awaitable(std::move(request));
+            const trace::Span span("isend", sizeof(T), rank_, MPI_BYTE);
+            MPI_Request request;
+            MPI_Isend(&data, static_cast<int>(sizeof(T)), MPI_BYTE, rank_, tag_,
+                comm_, &request);
+            return Awaitable(request);
         }
 
         template<typename T>
         std::enable_if_t<is_mpi_type<T>::value, Awaitable>
         operator<<(const T& data) {
-            auto request = std::make_unique<MPI_Request>();
-            MPI_Isend(&data, 1, get_mpi_type<T>(), rank_, 0,
-                MPI_COMM_WORLD, request.get());
-            return Awaitable(std::move(request));
+            const trace::Span span("isend", sizeof(T), rank_, get_mpi_type<T>());
+            MPI_Request request;
+            MPI_Isend(&data, 1, get_mpi_type<T>(), rank_, tag_,
+                comm_, &request);
+            return Awaitable(request);
         }
 
         template <typename T>
-        std::enable_if_t<!is_mpi_type<T>::value, Awaitable>
-        operator>>(const T& data) {
-            auto request = std::make_unique<MPI_Request>();
-            MPI_Irecv(&data, sizeof(T), MPI_BYTE, rank_, 0,
-                MPI_COMM_WORLD, request.get());
-            return Awaitable(std::move(request));
+        std::enable_if_t<!is_mpi_type<T>::value && !is_mpi_array<std::remove_cv_t<T>>::value, Awaitable>
+        operator>>(T& data) {
+            const trace::Span span("irecv", sizeof(T), rank_, MPI_BYTE);
+            MPI_Request request;
+            MPI_Irecv(&data, static_cast<int>(sizeof(T)), MPI_BYTE, rank_, tag_,
+                comm_, &request);
+            return Awaitable(request);
         }
 
         template <typename T>
         std::enable_if_t<is_mpi_type<T>::value, Awaitable>
-        operator>>(const T& data) {
-            auto request = std::make_unique<MPI_Request>();
-            MPI_Irecv(&data, 1, get_mpi_type<T>(), rank_, 0,
-                MPI_COMM_WORLD, request.get());
-            return Awaitable(std::move(request));
+        operator>>(T& data) {
+            const trace::Span span("irecv", sizeof(T), rank_, get_mpi_type<T>());
+            MPI_Request request;
+            MPI_Irecv(&data, 1, get_mpi_type<T>(), rank_, tag_,
+                comm_, &request);
+            return Awaitable(request);
         }
 
-        template<typename T>
+        template<typename T, typename A>
         std::enable_if_t<!is_mpi_type<T>::value, Awaitable>
-        operator<<(const array<T>& data) {
-            auto request = std::make_unique<MPI_Request>();
-            MPI_Isend(data.data(), static_cast<int>(data.size() * sizeof(T)),
-                MPI_BYTE, rank_, 0, MPI_COMM_WORLD, request.get());
-            return Awaitable(std::move(request));
+        operator<<(const array<T, A>& data) {
+            const trace::Span span("isend", data.size() * sizeof(T), rank_, MPI_BYTE);
+            MPI_Request request;
+            large::isend(data.data(), data.size() * sizeof(T),
+                MPI_BYTE, rank_, tag_, comm_, &request);
+            return Awaitable(request);
         }
 
-        template<typename T>
+        template<typename T, typename A>
         std::enable_if_t<is_mpi_type<T>::value, Awaitable>
-        operator<<(const array<T>& data) {
-            auto request = std::make_unique<MPI_Request>();
-            MPI_Isend(data.data(), static_cast<int>(data.size()),
-                get_mpi_type<T>(), rank_, 0, MPI_COMM_WORLD, request.get());
-            return Awaitable(std::move(request));
+        operator<<(const array<T, A>& data) {
+            const trace::Span span("isend", data.size() * sizeof(T), rank_, get_mpi_type<T>());
+            MPI_Request request;
+            large::isend(data.data(), data.size(),
+                get_mpi_type<T>(), rank_, tag_, comm_, &request);
+            return Awaitable(request);
         }
 
-        template <typename T>
+        template <typename T, typename A>
         std::enable_if_t<!is_mpi_type<T>::value, Awaitable>
-        operator>>(const array<T>& data) {
-            auto request = std::make_unique<MPI_Request>();
-            MPI_Irecv(data.data(), static_cast<int>(data.size()) * sizeof(T),
-                MPI_BYTE, rank_, 0, MPI_COMM_WORLD, request.get());
-            return Awaitable(std::move(request));
+        operator>>(const array<T, A>& data) {
+            const trace::Span span("irecv", data.size() * sizeof(T), rank_, MPI_BYTE);
+            MPI_Request request;
+            large::irecv(data.data(), data.size() * sizeof(T),
+                MPI_BYTE, rank_, tag_, comm_, &request);
+            return Awaitable(request);
         }
 
-        template <typename T>
+        template <typename T, typename A>
         std::enable_if_t<is_mpi_type<T>::value, Awaitable>
-        operator>>(const array<T>& data) {
-            auto request = std::make_unique<MPI_Request>();
-            MPI_Irecv(data.data(), static_cast<int>(data.size()),
-                get_mpi_type<T>(), rank_, 0, MPI_COMM_WORLD, request.get());
-            return Awaitable(std::move(request));
+        operator>>(const array<T, A>& data) {
+            const trace::Span span("irecv", data.size() * sizeof(T), rank_, get_mpi_type<T>());
+            MPI_Request request;
+            large::irecv(data.data(), data.size(),
+                get_mpi_type<T>(), rank_, tag_, comm_, &request);
+            return Awaitable(request);
+        }
+
+        template<typename T>
+        Awaitable operator<<(const array_view<T>& data) {
+            return *this << static_cast<const array<T>&>(data);
+        }
+
+        template <typename T>
+        Awaitable operator>>(const array_view<T>& data) {
+            return *this >> static_cast<const array<T>&>(data);
+        }
+
+    private:
+
+        int rank_;
+
+        MPI_Comm comm_;
+
+        int tag_;
+
+    };
+
+    /// Binds arrays to persistent requests, see Plan
+    class PersistentFunctor {
+    public:
+        explicit PersistentFunctor(const int rank, MPI_Comm comm, const int tag = 0)
+            : rank_(rank), comm_(comm), tag_(tag) {}
+
+        template<typename T, typename A>
+        std::enable_if_t<!is_mpi_type<T>::value, Plan<T, A>>
+        operator<<(array<T, A>&& data) {
+            Plan<T, A> plan(std::move(data), array<T, A>());
+            large::sendInit(plan.src().data(), plan.src().size() * sizeof(T),
+                MPI_BYTE, rank_, tag_, comm_, plan.request());
+            return plan;
+        }
+
+        template<typename T, typename A>
+        std::enable_if_t<is_mpi_type<T>::value, Plan<T, A>>
+        operator<<(array<T, A>&& data) {
+            Plan<T, A> plan(std::move(data), array<T, A>());
+            large::sendInit(plan.src().data(), plan.src().size(),
+                get_mpi_type<T>(), rank_, tag_, comm_, plan.request());
+            return plan;
+        }
+
+        template <typename T, typename A>
+        std::enable_if_t<!is_mpi_type<T>::value, Plan<T, A>>
+        operator>>(array<T, A>&& data) {
+            Plan<T, A> plan(array<T, A>(), std::move(data));
+            large::recvInit(plan.result().data(), plan.result().size() * sizeof(T),
+                MPI_BYTE, rank_, tag_, comm_, plan.request());
+            return plan;
+        }
+
+        template <typename T, typename A>
+        std::enable_if_t<is_mpi_type<T>::value, Plan<T, A>>
+        operator>>(array<T, A>&& data) {
+            Plan<T, A> plan(array<T, A>(), std::move(data));
+            large::recvInit(plan.result().data(), plan.result().size(),
+                get_mpi_type<T>(), rank_, tag_, comm_, plan.request());
+            return plan;
         }
 
     private:
 
         int rank_;
 
+        MPI_Comm comm_;
+
+        int tag_;
+
     };
 
-    explicit RemoteProcess(const int rank, const int commSize) : Process(rank, commSize) {}
+    /// Peer rank within comm
+    explicit RemoteProcess(std::shared_ptr<Communicator> comm, const int rank)
+        : Process(std::move(comm), rank) {}
 
     explicit RemoteProcess(const RemoteProcess& other) = delete;
 
@@ -185,12 +342,16 @@ public:
 
     RemoteProcess& operator=(RemoteProcess&& other) = default;
 
-    [[nodiscard]] SyncFunctor sync() const {
-        return SyncFunctor(rank());
+    [[nodiscard]] SyncFunctor sync(const int tag = 0) const {
+        return SyncFunctor(rank(), comm(), tag);
+    }
+
+    [[nodiscard]] AsyncFunctor async(const int tag = 0) const {
+        return AsyncFunctor(rank(), comm(), tag);
     }
 
-    [[nodiscard]] AsyncFunctor async() const {
-        return AsyncFunctor(rank());
+    [[nodiscard]] PersistentFunctor persistent(const int tag = 0) const {
+        return PersistentFunctor(rank(), comm(), tag);
     }
 
 };
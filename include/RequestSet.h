@@ -0,0 +1,182 @@
+#ifndef REQUEST_SET_H
+#define REQUEST_SET_H
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+#include <mpi.h>
+#include <RemoteProcess.h>
+#include <Trace.h>
+
+
+
+namespace mpi {
+
+/// Group of outstanding requests stored contiguously, so they complete with a single
+/// MPI_Waitall/MPI_Waitany/MPI_Testsome call. An optional callback runs when its request
+/// completes. Buffers of every request must outlive the set or its completion.
+class RequestSet {
+public:
+
+    using Callback = std::function<void()>;
+
+    RequestSet() = default;
+
+    RequestSet(const RequestSet& other) = delete;
+
+    RequestSet(RequestSet&& other) noexcept
+        : requests_(std::move(other.requests_)), callbacks_(std::move(other.callbacks_)),
+          indices_(std::move(other.indices_)), pending_(std::exchange(other.pending_, 0)) {}
+
+    RequestSet& operator=(const RequestSet& other) = delete;
+
+    /// Waits for the requests still pending here before taking over those of other,
+    /// their callbacks are dropped as on destruction
+    RequestSet& operator=(RequestSet&& other) noexcept {
+        if (this != &other) {
+            drain();
+            requests_ = std::move(other.requests_);
+            callbacks_ = std::move(other.callbacks_);
+            indices_ = std::move(other.indices_);
+            pending_ = std::exchange(other.pending_, 0);
+        }
+        return *this;
+    }
+
+    ~RequestSet() {
+        drain();
+    }
+
+    /// Returns the index of the request inside the set
+    size_t add(MPI_Request request, Callback callback = {}) {
+        requests_.push_back(request);
+        callbacks_.push_back(std::move(callback));
+        if (request != MPI_REQUEST_NULL) {
+            ++pending_;
+        }
+        return requests_.size() - 1;
+    }
+
+    size_t add(RemoteProcess::Awaitable&& awaitable, Callback callback = {}) {
+        return add(awaitable.release(), std::move(callback));
+    }
+
+    RequestSet& operator+=(RemoteProcess::Awaitable&& awaitable) {
+        add(std::move(awaitable));
+        return *this;
+    }
+
+    void reserve(const size_t size) {
+        requests_.reserve(size);
+        callbacks_.reserve(size);
+        indices_.reserve(size);
+    }
+
+    /// Blocks until every request has completed, then runs the outstanding callbacks in order
+    void waitAll() {
+        if (pending_ == 0) {
+            return;
+        }
+        {
+            const trace::Span span("waitAll", 0, -1, MPI_DATATYPE_NULL);
+            MPI_Waitall(static_cast<int>(requests_.size()), requests_.data(), MPI_STATUSES_IGNORE);
+        }
+        pending_ = 0;
+        for (size_t i = 0; i < callbacks_.size(); ++i) {
+            complete(i);
+        }
+    }
+
+    /// Blocks until one request completes and returns its index, nullopt if none is pending
+    std::optional<size_t> waitAny() {
+        if (pending_ == 0) {
+            return std::nullopt;
+        }
+        int index = MPI_UNDEFINED;
+        {
+            const trace::Span span("waitAny", 0, -1, MPI_DATATYPE_NULL);
+            MPI_Waitany(static_cast<int>(requests_.size()), requests_.data(), &index, MPI_STATUS_IGNORE);
+        }
+        if (index == MPI_UNDEFINED) {
+            pending_ = 0;
+            return std::nullopt;
+        }
+        --pending_;
+        complete(static_cast<size_t>(index));
+        return static_cast<size_t>(index);
+    }
+
+    /// Completes whatever has finished without blocking and returns how many requests did
+    size_t testSome() {
+        if (pending_ == 0) {
+            return 0;
+        }
+        indices_.resize(requests_.size());
+        int count = 0;
+        MPI_Testsome(static_cast<int>(requests_.size()), requests_.data(), &count, indices_.data(),
+                     MPI_STATUSES_IGNORE);
+        if (count == MPI_UNDEFINED) {
+            pending_ = 0;
+            return 0;
+        }
+        pending_ -= static_cast<size_t>(count);
+        for (int i = 0; i < count; ++i) {
+            complete(static_cast<size_t>(indices_[static_cast<size_t>(i)]));
+        }
+        return static_cast<size_t>(count);
+    }
+
+    /// Returns true once every request has completed, without blocking
+    [[nodiscard]] bool test() {
+        testSome();
+        return pending_ == 0;
+    }
+
+    /// Number of requests added since the last clear()
+    [[nodiscard]] size_t size() const { return requests_.size(); }
+
+    /// Number of requests not completed yet
+    [[nodiscard]] size_t pending() const { return pending_; }
+
+    [[nodiscard]] bool empty() const { return pending_ == 0; }
+
+    /// Waits for the outstanding requests and forgets all of them, keeping the storage
+    void clear() {
+        waitAll();
+        requests_.clear();
+        callbacks_.clear();
+    }
+
+private:
+
+    /// Completes every pending request without running callbacks
+    void drain() noexcept {
+        if (pending_ > 0) {
+            MPI_Waitall(static_cast<int>(requests_.size()), requests_.data(), MPI_STATUSES_IGNORE);
+            pending_ = 0;
+        }
+    }
+
+    void complete(const size_t index) {
+        if (callbacks_[index]) {
+            Callback callback = std::move(callbacks_[index]);
+            callbacks_[index] = nullptr;
+            callback();
+        }
+    }
+
+    std::vector<MPI_Request> requests_;
+
+    std::vector<Callback> callbacks_;
+
+    std::vector<int> indices_;
+
+    size_t pending_ = 0;
+
+};
+
+}
+
+#endif //REQUEST_SET_H
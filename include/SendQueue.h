@@ -0,0 +1,193 @@
+#ifndef SEND_QUEUE_H
+#define SEND_QUEUE_H
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <mpi.h>
+#include <RemoteProcess.h>
+#include <array.h>
+#include <large_count.h>
+#include <mpi_types.h>
+
+
+
+namespace mpi {
+
+/// Funnels sends from many threads through the one thread allowed to call MPI
+/// (MPI_THREAD_FUNNELED). Any thread may push() without taking a lock. The communication thread
+/// calls poll()/flush(), which post the queued sends with MPI_Isend, in push order per producer,
+/// and fulfil the returned futures as the sends complete. No MPI call happens on push().
+class SendQueue {
+public:
+
+    SendQueue() : head_(&stub_), tail_(&stub_) {}
+
+    SendQueue(const SendQueue& other) = delete;
+
+    SendQueue& operator=(const SendQueue& other) = delete;
+
+    /// Must run on the communication thread, completes everything still queued
+    ~SendQueue() {
+        flush();
+    }
+
+    /// Queues data for remote, thread-safe and lock-free. The queue owns data until the send completes.
+    template<typename T, typename A>
+    std::future<void> push(const RemoteProcess& remote, array<T, A>&& data, const int tag = 0) {
+        auto* node = new Send<T, A>(std::move(data), remote.rank(), remote.comm(), tag);
+        std::future<void> future = node->done_.get_future();
+        enqueue(node);
+        return future;
+    }
+
+    /// Posts whatever was queued and completes finished sends without blocking.
+    /// Communication thread only, returns the number of sends completed.
+    size_t poll() {
+        while (Node* node = dequeue()) {
+            MPI_Request request;
+            node->post(&request);
+            requests_.push_back(request);
+            inflight_.emplace_back(node);
+        }
+        if (requests_.empty()) {
+            return 0;
+        }
+
+        indices_.resize(requests_.size());
+        int count = 0;
+        MPI_Testsome(static_cast<int>(requests_.size()), requests_.data(), &count, indices_.data(),
+                     MPI_STATUSES_IGNORE);
+        if (count == MPI_UNDEFINED || count == 0) {
+            return 0;
+        }
+        for (int i = 0; i < count; ++i) {
+            auto& node = inflight_[static_cast<size_t>(indices_[static_cast<size_t>(i)])];
+            node->complete();
+            node.reset();
+        }
+
+        // Drops the completed entries, keeping the order of the others
+        size_t kept = 0;
+        for (size_t i = 0; i < requests_.size(); ++i) {
+            if (inflight_[i]) {
+                requests_[kept] = requests_[i];
+                inflight_[kept] = std::move(inflight_[i]);
+                ++kept;
+            }
+        }
+        requests_.resize(kept);
+        inflight_.resize(kept);
+        return static_cast<size_t>(count);
+    }
+
+    /// Polls until the queue is empty and every posted send has completed.
+    /// Sends pushed concurrently may or may not be included.
+    void flush() {
+        do {
+            poll();
+        } while (!inflight_.empty() || !queueEmpty());
+    }
+
+    /// Number of sends posted and not completed yet
+    [[nodiscard]] size_t inflight() const { return inflight_.size(); }
+
+private:
+
+    struct Node {
+        virtual ~Node() = default;
+
+        virtual void post(MPI_Request*) {}
+
+        virtual void complete() {}
+
+        std::atomic<Node*> next = nullptr;
+    };
+
+    template<typename T, typename A>
+    struct Send final : Node {
+        Send(array<T, A>&& data, const int rank, MPI_Comm comm, const int tag)
+            : data_(std::move(data)), rank_(rank), comm_(comm), tag_(tag) {}
+
+        /// The datatype is resolved here, since creating it is an MPI call
+        void post(MPI_Request* request) override {
+            if constexpr (is_mpi_type<T>::value) {
+                large::isend(data_.data(), data_.size(), get_mpi_type<T>(), rank_, tag_, comm_, request);
+            } else {
+                large::isend(data_.data(), data_.size() * sizeof(T), MPI_BYTE, rank_, tag_, comm_, request);
+            }
+        }
+
+        void complete() override {
+            done_.set_value();
+        }
+
+        array<T, A> data_;
+
+        int rank_;
+
+        MPI_Comm comm_;
+
+        int tag_;
+
+        std::promise<void> done_;
+    };
+
+    /// Intrusive multi-producer single-consumer queue (Vyukov), producers only swap head_
+    void enqueue(Node* node) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    /// Consumer side, returns nullptr when empty or when a producer is halfway through enqueue()
+    Node* dequeue() {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_) {
+            if (!next) {
+                return nullptr;
+            }
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            tail_ = next;
+            return tail;
+        }
+        if (tail != head_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        enqueue(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next) {
+            tail_ = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+    [[nodiscard]] bool queueEmpty() const {
+        return tail_ == &stub_ && !stub_.next.load(std::memory_order_acquire);
+    }
+
+    Node stub_;
+
+    std::atomic<Node*> head_;
+
+    Node* tail_;
+
+    std::vector<MPI_Request> requests_;
+
+    std::vector<std::unique_ptr<Node>> inflight_;
+
+    std::vector<int> indices_;
+
+};
+
+}
+
+#endif //SEND_QUEUE_H
@@ -0,0 +1,188 @@
+#ifndef SORT_H
+#define SORT_H
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <mpi.h>
+#include <Communicator.h>
+#include <LocalProcess.h>
+#include <Operations.h>
+#include <Trace.h>
+#include <array.h>
+
+
+
+namespace mpi {
+
+namespace detail {
+
+/// Merges the sorted runs [bounds[i], bounds[i + 1]) of src into dst, ties keep run order
+template<typename T, typename Compare>
+void mergeRuns(const T* src, const std::vector<size_t>& bounds, T* dst, Compare& comp) {
+    // Cursor into run, the heap top is the run with the smallest head
+    using Cursor = std::pair<size_t, size_t>;
+    const auto later = [&](const Cursor& a, const Cursor& b) {
+        if (comp(src[b.first], src[a.first])) {
+            return true;
+        }
+        return !comp(src[a.first], src[b.first]) && b.second < a.second;
+    };
+    std::vector<Cursor> storage;
+    storage.reserve(bounds.size() - 1);
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(later)> heads(later, std::move(storage));
+    for (size_t run = 0; run + 1 < bounds.size(); ++run) {
+        if (bounds[run] < bounds[run + 1]) {
+            heads.emplace(bounds[run], run);
+        }
+    }
+    while (!heads.empty()) {
+        auto [index, run] = heads.top();
+        heads.pop();
+        *dst++ = src[index];
+        if (++index < bounds[run + 1]) {
+            heads.emplace(index, run);
+        }
+    }
+}
+
+/// Sorts data with up to threads std::sort calls over equal slices, merged afterwards
+template<typename T, typename A, typename Compare>
+[[nodiscard]] array<T, A> localSort(array<T, A>&& data, Compare& comp, const size_t threads) {
+    // Below this many elements per thread, spawning costs more than it saves
+    constexpr size_t grain = size_t{1} << 14;
+    const size_t size = data.size();
+    const size_t slices = std::clamp<size_t>(size / grain, 1, threads);
+    if (slices == 1) {
+        std::sort(data.data(), data.data() + size, comp);
+        return std::move(data);
+    }
+    std::vector<size_t> bounds(slices + 1);
+    for (size_t i = 0; i <= slices; ++i) {
+        bounds[i] = size * i / slices;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(slices - 1);
+    for (size_t i = 1; i < slices; ++i) {
+        workers.emplace_back([&, i] { std::sort(data.data() + bounds[i], data.data() + bounds[i + 1], comp); });
+    }
+    std::sort(data.data(), data.data() + bounds[1], comp);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    array<T, A> sorted(size);
+    mergeRuns(data.data(), bounds, sorted.data(), comp);
+    return sorted;
+}
+
+/// hardware_concurrency() shared among the ranks of this node
+inline size_t threadsPerRank(const Communicator& comm) {
+    return std::max<size_t>(std::thread::hardware_concurrency() / static_cast<size_t>(comm.nodeSize()), 1);
+}
+
+/// allToAllv of the buckets of data, which also reports how many elements came from each rank.
+/// The received counts are needed to merge the runs, so they are exchanged only once.
+template<typename T, typename A>
+[[nodiscard]] array<T, A> exchangeBuckets(const LocalProcess& local, array<T, A> data,
+                                          const array<int>& partition, const array<int>& received) {
+    MPI_Alltoall(partition.data(), 1, MPI_INT, received.data(), 1, MPI_INT, local.comm());
+    size_t total = 0;
+    for (size_t i = 0; i < received.size(); ++i) {
+        total += static_cast<size_t>(received[i]);
+    }
+    array<T, A> ret(total);
+    if constexpr (is_mpi_type<T>::value) {
+        MPI_Alltoallv(data.data(), partition.data(), displacements(partition).data(), get_mpi_type<T>(),
+            ret.data(), received.data(), displacements(received).data(), get_mpi_type<T>(), local.comm());
+    } else {
+        const array<int> sendCount = scaledCounts(partition, sizeof(T));
+        const array<int> recvCount = scaledCounts(received, sizeof(T));
+        MPI_Alltoallv(data.data(), sendCount.data(), displacements(sendCount).data(), MPI_BYTE,
+            ret.data(), recvCount.data(), displacements(recvCount).data(), MPI_BYTE, local.comm());
+    }
+    return ret;
+}
+
+}
+
+/// Sorts the elements scattered over all ranks of the communicator by comp (parallel sorting
+/// by regular sampling). Every rank sorts locally, contributes commSize - 1 evenly spaced samples,
+/// all ranks pick the same commSize - 1 splitters from the gathered samples, the buckets are
+/// exchanged with allToAllv and the received runs are k-way merged. A final allToAllv evens out
+/// skewed buckets, so rank i returns the i-th block of the sorted sequence with the sizes of
+/// balancedCounts(). threads bounds the local sort, 0 splits the node's cores among its ranks.
+/// Collective.
+template<typename T, typename A, typename Compare = std::less<T>>
+[[nodiscard]] array<T, A> sort(LocalProcess::out_op_args<T, A>&& args, Compare comp = Compare(),
+                               size_t threads = 0) {
+    auto& [local, data] = args;
+    const trace::Span span("sort", data.size() * sizeof(T), -1, MPI_DATATYPE_NULL);
+    const auto commSize = static_cast<size_t>(local.commSize());
+    if (threads == 0) {
+        threads = detail::threadsPerRank(*local.communicator());
+    }
+    array<T, A> sorted = detail::localSort(std::move(data), comp, threads);
+    const size_t size = sorted.size();
+    if (commSize == 1) {
+        return sorted;
+    }
+
+    array<T, A> samples(size == 0 ? 0 : commSize - 1);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = sorted[(i + 1) * size / commSize];
+    }
+    array<T, A> gathered = allGatherv<T, A>(local.forward(std::move(samples)));
+    std::sort(gathered.data(), gathered.data() + gathered.size(), comp);
+
+    // Bucket i takes the elements up to and including splitter i
+    array<int> partition(commSize);
+    size_t begin = 0;
+    for (size_t i = 0; i < commSize; ++i) {
+        size_t end = size;
+        if (i + 1 < commSize && !gathered.empty()) {
+            const T& splitter = gathered[(i + 1) * gathered.size() / commSize];
+            end = static_cast<size_t>(std::upper_bound(sorted.data() + begin, sorted.data() + size, splitter, comp)
+                - sorted.data());
+        }
+        partition[i] = checkedCount(end - begin);
+        begin = end;
+    }
+
+    const array<int> received(commSize);
+    const array<T, A> buckets = detail::exchangeBuckets(local, std::move(sorted), partition, received);
+    std::vector<size_t> bounds(commSize + 1);
+    for (size_t i = 0; i < commSize; ++i) {
+        bounds[i + 1] = bounds[i] + static_cast<size_t>(received[i]);
+    }
+    array<T, A> merged(buckets.size());
+    detail::mergeRuns(buckets.data(), bounds, merged.data(), comp);
+
+    // Ships every element to the rank owning its global position in the balanced layout
+    const array<unsigned long> sizes = allGather<unsigned long>(
+        local.forward(array<unsigned long>({merged.size()})));
+    size_t total = 0;
+    size_t first = 0;
+    for (size_t i = 0; i < commSize; ++i) {
+        if (i == static_cast<size_t>(local.rank())) {
+            first = total;
+        }
+        total += sizes[i];
+    }
+    const auto blockStart = [&](const size_t rank) {
+        return rank * (total / commSize) + std::min(rank, total % commSize);
+    };
+    const size_t last = first + merged.size();
+    for (size_t i = 0; i < commSize; ++i) {
+        const size_t from = std::max(first, blockStart(i));
+        const size_t to = std::min(last, blockStart(i + 1));
+        partition[i] = checkedCount(from < to ? to - from : 0);
+    }
+    return allToAllv<T, A>(local.forward(std::move(merged)), partition);
+}
+
+}
+
+#endif //SORT_H
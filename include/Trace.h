@@ -0,0 +1,166 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <mpi.h>
+
+
+
+namespace mpi::trace {
+
+/// One timed wrapper call. name points to a string literal, type is resolved to its MPI name
+/// only when the trace is written.
+struct Event {
+
+    const char* name;
+
+    int64_t begin;  // ns since the trace epoch
+
+    int64_t end;
+
+    uint64_t bytes;
+
+    int peer;  // peer or root rank, -1 for rootless collectives
+
+    MPI_Datatype type;
+
+    uint32_t thread;
+
+};
+
+/// Fixed-capacity ring of events with a single writer, every thread of the rank records into
+/// its own. The writer never waits; once full, the oldest events are overwritten. Readers only
+/// look at a ring after its writer has stopped.
+class RingBuffer {
+public:
+
+    explicit RingBuffer(const size_t capacity)
+        : events_(std::make_unique<Event[]>(capacity)), capacity_(capacity) {}
+
+    void push(const Event& event) {
+        const uint64_t index = next_.load(std::memory_order_relaxed);
+        events_[index % capacity_] = event;
+        next_.store(index + 1, std::memory_order_release);
+    }
+
+    /// Number of events held, at most capacity()
+    [[nodiscard]] size_t size() const {
+        const uint64_t next = next_.load(std::memory_order_acquire);
+        return next < capacity_ ? static_cast<size_t>(next) : capacity_;
+    }
+
+    [[nodiscard]] size_t capacity() const { return capacity_; }
+
+    /// Total number of events pushed, overwritten ones included
+    [[nodiscard]] uint64_t pushed() const { return next_.load(std::memory_order_acquire); }
+
+    /// i-th oldest event still held
+    [[nodiscard]] const Event& operator[](const size_t i) const {
+        const uint64_t next = next_.load(std::memory_order_acquire);
+        const uint64_t first = next < capacity_ ? 0 : next - capacity_;
+        return events_[(first + i) % capacity_];
+    }
+
+private:
+
+    std::unique_ptr<Event[]> events_;
+
+    size_t capacity_;
+
+    std::atomic<uint64_t> next_ = 0;
+
+};
+
+/// Set while tracing, checked first by every Span so disabled tracing costs one relaxed load
+inline std::atomic<bool> active = false;
+
+/// Spans between their enabled() check and their push, finish() waits for them to drain
+inline std::atomic<int> recording = 0;
+
+/// Bumped by every start(), threads register a new ring when theirs is from an older session
+inline std::atomic<uint64_t> session = 0;
+
+inline std::chrono::steady_clock::time_point epoch;
+
+inline std::string output;
+
+[[nodiscard]] inline bool enabled() {
+    return active.load(std::memory_order_relaxed);
+}
+
+[[nodiscard]] inline int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+[[nodiscard]] inline uint32_t threadIndex() {
+    static std::atomic<uint32_t> threads = 0;
+    thread_local const uint32_t index = threads.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+/// Allocates and registers the ring of the calling thread for the current session
+RingBuffer* registerThread();
+
+/// Ring of the calling thread, registered on its first event of a session
+[[nodiscard]] inline RingBuffer& threadRing() {
+    thread_local RingBuffer* ring = nullptr;
+    thread_local uint64_t ringSession = 0;
+    const uint64_t current = session.load(std::memory_order_acquire);
+    if (ring == nullptr || ringSession != current) {
+        ring = registerThread();
+        ringSession = current;
+    }
+    return *ring;
+}
+
+/// Starts recording into rings of capacity events per thread, comm synchronizes the epoch of all ranks.
+/// The Chrome trace is written to path, the per-op summary to path + ".summary.txt". Collective.
+void start(MPI_Comm comm, const std::string& path, size_t capacity = size_t{1} << 20);
+
+/// Stops recording, merges the events of every rank on rank 0 and writes the trace and the
+/// summary. Collective, must run before MPI_Finalize.
+void finish(MPI_Comm comm);
+
+/// Records the wrapper call spanning its lifetime
+class Span {
+public:
+
+    Span(const char* name, const size_t bytes, const int peer, MPI_Datatype type) {
+        if (enabled()) {
+            event_ = {name, now(), 0, bytes, peer, type, threadIndex()};
+            recording_ = true;
+        }
+    }
+
+    Span(const Span& other) = delete;
+
+    Span& operator=(const Span& other) = delete;
+
+    ~Span() {
+        if (!recording_) {
+            return;
+        }
+        // Announce the push before checking again, so finish() either sees it or stops it
+        recording.fetch_add(1, std::memory_order_seq_cst);
+        if (active.load(std::memory_order_seq_cst)) {
+            event_.end = now();
+            threadRing().push(event_);
+        }
+        recording.fetch_sub(1, std::memory_order_release);
+    }
+
+private:
+
+    Event event_;
+
+    bool recording_ = false;
+
+};
+
+}
+
+#endif //TRACE_H
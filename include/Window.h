@@ -0,0 +1,196 @@
+#ifndef WINDOW_H
+#define WINDOW_H
+
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <mpi.h>
+#include <Communicator.h>
+#include <RemoteProcess.h>
+#include <array.h>
+#include <large_count.h>
+#include <mpi_types.h>
+
+
+
+namespace mpi {
+
+/// One-sided access to size elements exposed by every rank of a communicator, allocated with
+/// MPI_Win_allocate. Offsets are in elements of T. Operations must run inside an epoch: either
+/// between two fence() calls (active target) or between lockAll() and unlockAll() (passive target).
+/// Construction and destruction are collective.
+template<typename T>
+class Window {
+public:
+
+    static_assert(is_mpi_type<T>::value, "Window: T must be an mpi type, describe structs with mpi_fields<T>");
+
+    using Iterator = typename array<T>::Iterator;
+
+    Window(std::shared_ptr<Communicator> comm, const size_t size)
+        : comm_(std::move(comm)), size_(size) {
+        if (MPI_Win_allocate(static_cast<MPI_Aint>(size_ * sizeof(T)), static_cast<int>(sizeof(T)),
+                             MPI_INFO_NULL, comm_->get(), &array_, &window_) != MPI_SUCCESS) {
+            throw std::runtime_error("MPI_Win_allocate failed");
+        }
+        std::uninitialized_value_construct_n(array_, size_);
+    }
+
+    Window(const Window& other) = delete;
+
+    Window(Window&& other) noexcept
+        : comm_(std::move(other.comm_)), size_(other.size_), array_(other.array_), window_(other.window_) {
+        other.size_ = 0;
+        other.array_ = nullptr;
+        other.window_ = MPI_WIN_NULL;
+    }
+
+    Window& operator=(const Window& other) = delete;
+
+    ~Window() {
+        int finalized = 0;
+        MPI_Finalized(&finalized);
+        if (window_ != MPI_WIN_NULL && !finalized) {
+            MPI_Win_free(&window_);
+        }
+    }
+
+    /// Opens/closes an active target epoch
+    void fence(const int assert = 0) const {
+        MPI_Win_fence(assert, window_);
+    }
+
+    /// Opens a passive target epoch on every rank
+    void lockAll() const {
+        MPI_Win_lock_all(0, window_);
+    }
+
+    void unlockAll() const {
+        MPI_Win_unlock_all(window_);
+    }
+
+    /// Completes all operations issued to target within a passive target epoch
+    void flush(const int target) const {
+        MPI_Win_flush(target, window_);
+    }
+
+    void flushAll() const {
+        MPI_Win_flush_all(window_);
+    }
+
+    /// Makes remote writes to the local part visible to local loads
+    void sync() const {
+        MPI_Win_sync(window_);
+    }
+
+    template<typename A>
+    void put(const array<T, A>& data, const int target, const size_t offset) const {
+        check(data.size(), offset);
+        large::put(data.data(), data.size(), get_mpi_type<T>(), target, static_cast<MPI_Aint>(offset), window_);
+    }
+
+    template<typename A>
+    void get(const array<T, A>& data, const int target, const size_t offset) const {
+        check(data.size(), offset);
+        large::get(data.data(), data.size(), get_mpi_type<T>(), target, static_cast<MPI_Aint>(offset), window_);
+    }
+
+    template<typename A>
+    void accumulate(const array<T, A>& data, const int target, const size_t offset, MPI_Op op = MPI_SUM) const {
+        check(data.size(), offset);
+        large::accumulate(data.data(), data.size(), get_mpi_type<T>(), target, static_cast<MPI_Aint>(offset), op,
+            window_);
+    }
+
+    /// Atomically applies op to the remote element and returns its previous value.
+    /// Passive target only, the call flushes target.
+    T fetchAndOp(const T& value, const int target, const size_t offset, MPI_Op op = MPI_SUM) const {
+        static_assert(is_builtin_mpi_type<T>::value, "Window::fetchAndOp: MPI only accepts predefined datatypes");
+        check(1, offset);
+        T previous{};
+        MPI_Fetch_and_op(&value, &previous, get_mpi_type<T>(), target,
+            static_cast<MPI_Aint>(offset), op, window_);
+        flush(target);
+        return previous;
+    }
+
+    /// Atomically replaces the remote element with value if it equals compare and returns the
+    /// previous value. Passive target only, the call flushes target.
+    T compareAndSwap(const T& value, const T& compare, const int target, const size_t offset) const {
+        static_assert(is_builtin_mpi_type<T>::value, "Window::compareAndSwap: MPI only accepts predefined datatypes");
+        check(1, offset);
+        T previous{};
+        MPI_Compare_and_swap(&value, &compare, &previous, get_mpi_type<T>(), target,
+            static_cast<MPI_Aint>(offset), window_);
+        flush(target);
+        return previous;
+    }
+
+    /// Request-based put(), passive target only. data must outlive the returned Awaitable.
+    template<typename A>
+    RemoteProcess::Awaitable rput(const array<T, A>& data, const int target, const size_t offset) const {
+        check(data.size(), offset);
+        MPI_Request request;
+        large::rput(data.data(), data.size(), get_mpi_type<T>(), target, static_cast<MPI_Aint>(offset), window_,
+            &request);
+        return RemoteProcess::Awaitable(request);
+    }
+
+    template<typename A>
+    RemoteProcess::Awaitable rget(const array<T, A>& data, const int target, const size_t offset) const {
+        check(data.size(), offset);
+        MPI_Request request;
+        large::rget(data.data(), data.size(), get_mpi_type<T>(), target, static_cast<MPI_Aint>(offset), window_,
+            &request);
+        return RemoteProcess::Awaitable(request);
+    }
+
+    template<typename A>
+    RemoteProcess::Awaitable raccumulate(const array<T, A>& data, const int target, const size_t offset,
+                                         MPI_Op op = MPI_SUM) const {
+        check(data.size(), offset);
+        MPI_Request request;
+        large::raccumulate(data.data(), data.size(), get_mpi_type<T>(), target, static_cast<MPI_Aint>(offset), op,
+            window_, &request);
+        return RemoteProcess::Awaitable(request);
+    }
+
+    Iterator begin() const { return Iterator(array_); }
+
+    Iterator end() const { return Iterator(array_ + size_); }
+
+    /// Number of elements exposed by every rank
+    [[nodiscard]] size_t size() const { return size_; }
+
+    [[nodiscard]] T* data() const { return array_; }
+
+    [[nodiscard]] MPI_Win window() const { return window_; }
+
+    T& operator[](const size_t index) const {
+        if (index >= size_) {
+            throw std::out_of_range("Window::operator[]");
+        }
+        return array_[index];
+    }
+
+private:
+
+    void check(const size_t count, const size_t offset) const {
+        if (offset + count > size_) {
+            throw std::out_of_range("Window: access past the exposed elements");
+        }
+    }
+
+    std::shared_ptr<Communicator> comm_;
+
+    size_t size_;
+
+    T* array_ = nullptr;
+
+    MPI_Win window_ = MPI_WIN_NULL;
+
+};
+
+}
+
+#endif //WINDOW_H
@@ -0,0 +1,143 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <mpi.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+
+
+namespace mpi {
+
+/// Storage policies for mpi::array. A policy provides
+///     static T* allocate(size_t size);
+///     static void deallocate(T* ptr, size_t size) noexcept;
+/// and owns both the memory and the lifetime of the elements. allocate() releases the memory
+/// again when constructing an element throws.
+
+/// new T[size](), every element is value-initialized
+template<typename T>
+struct new_allocator {
+
+    static T* allocate(const size_t size) {
+        return new T[size]();
+    }
+
+    static void deallocate(T* ptr, size_t) noexcept {
+        delete[] ptr;
+    }
+
+};
+
+/// Over-aligned storage, 64 bytes (one cache line / AVX-512 vector) by default
+template<typename T, size_t Alignment = 64>
+struct aligned_allocator {
+
+    static_assert(Alignment >= alignof(T) && (Alignment & (Alignment - 1)) == 0,
+        "aligned_allocator: alignment must be a power of two of at least alignof(T)");
+
+    static T* allocate(const size_t size) {
+        T* ptr = allocate_raw(size);
+        try {
+            std::uninitialized_value_construct_n(ptr, size);
+        } catch (...) {
+            deallocate_raw(ptr);
+            throw;
+        }
+        return ptr;
+    }
+
+    static void deallocate(T* ptr, const size_t size) noexcept {
+        if (ptr) {
+            std::destroy_n(ptr, size);
+            deallocate_raw(ptr);
+        }
+    }
+
+protected:
+
+    static T* allocate_raw(const size_t size) {
+        return static_cast<T*>(::operator new[](std::max<size_t>(size, 1) * sizeof(T),
+            std::align_val_t{Alignment}));
+    }
+
+    static void deallocate_raw(T* ptr) noexcept {
+        ::operator delete[](ptr, std::align_val_t{Alignment});
+    }
+
+};
+
+/// 2 MiB aligned storage advised to be backed by transparent huge pages where supported
+template<typename T>
+struct huge_page_allocator : aligned_allocator<T, size_t{1} << 21> {
+
+    static T* allocate(const size_t size) {
+        T* ptr = huge_page_allocator::allocate_raw(size);
+#ifdef MADV_HUGEPAGE
+        madvise(ptr, size * sizeof(T), MADV_HUGEPAGE);
+#endif
+        try {
+            std::uninitialized_value_construct_n(ptr, size);
+        } catch (...) {
+            huge_page_allocator::deallocate_raw(ptr);
+            throw;
+        }
+        return ptr;
+    }
+
+};
+
+/// Aligned storage left uninitialized, so the first write is the first touch
+template<typename T, size_t Alignment = 64>
+struct uninitialized_allocator : aligned_allocator<T, Alignment> {
+
+    static_assert(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>,
+        "uninitialized_allocator: T must be trivially constructible and destructible");
+
+    static T* allocate(const size_t size) {
+        T* ptr = uninitialized_allocator::allocate_raw(size);
+        std::uninitialized_default_construct_n(ptr, size);
+        return ptr;
+    }
+
+};
+
+/// Memory from MPI_Alloc_mem, which interconnects can register for RDMA up front.
+/// Elements are default-initialized, i.e. left untouched for trivial types.
+template<typename T>
+struct mpi_allocator {
+
+    static T* allocate(const size_t size) {
+        void* ptr = nullptr;
+        if (MPI_Alloc_mem(static_cast<MPI_Aint>(std::max<size_t>(size, 1) * sizeof(T)),
+                          MPI_INFO_NULL, &ptr) != MPI_SUCCESS || !ptr) {
+            throw std::bad_alloc();
+        }
+        try {
+            std::uninitialized_default_construct_n(static_cast<T*>(ptr), size);
+        } catch (...) {
+            MPI_Free_mem(ptr);
+            throw;
+        }
+        return static_cast<T*>(ptr);
+    }
+
+    static void deallocate(T* ptr, const size_t size) noexcept {
+        if (ptr) {
+            std::destroy_n(ptr, size);
+            MPI_Free_mem(ptr);
+        }
+    }
+
+};
+
+}
+
+#endif //ALLOCATOR_H
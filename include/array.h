@@ -1,17 +1,26 @@
 #ifndef ARRAY_H
 #define ARRAY_H
 
+#include <algorithm>
+#include <allocator.h>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 
 namespace mpi {
 
-template <typename T>
+/// Owning contiguous buffer. Allocator is a storage policy from allocator.h, e.g.
+/// mpi_allocator for RDMA-registered memory or uninitialized_allocator for large receive buffers.
+template <typename T, typename Allocator = new_allocator<T>>
 class array {
 public:
 
     using value_type = T;
 
+    using allocator_type = Allocator;
+
     class Iterator {
     public:
         using iterator_category = std::random_access_iterator_tag;
@@ -54,14 +63,14 @@ public:
     array() : size_(0), array_(nullptr) {}
 
     explicit array(const size_t size)
-        : size_(size), array_(new T[size_]) {
+        : size_(size), array_(Allocator::allocate(size_)) {
         if (!array_) {
             throw std::bad_alloc();
         }
     }
 
     explicit array(const std::vector<T>& vector)
-        : size_(vector.size()), array_(new T[size_]) {
+        : size_(vector.size()), array_(Allocator::allocate(size_)) {
         if (!array_) {
             throw std::bad_alloc();
         }
@@ -69,17 +78,18 @@ public:
     }
 
     explicit array(const std::vector<T>& vector, const size_t offset, const size_t size)
-        : size_(size), array_(new T[size_]) {
+        : size_(size), array_(Allocator::allocate(size_)) {
         if (!array_) {
             throw std::bad_alloc();
         }
-        const size_t diff = size_ - size;
-        std::copy(vector.begin() + static_cast<long>(offset),
-            vector.end() - static_cast<long>(diff), this->begin());
+        if (offset + size > vector.size()) {
+            throw std::out_of_range("array::array");
+        }
+        std::copy_n(vector.begin() + static_cast<long>(offset), size_, this->begin());
     }
 
     array(const array& other)
-        : size_(other.size()), array_(new T[size_]) {
+        : size_(other.size()), array_(Allocator::allocate(size_)) {
         if (!array_) {
             throw std::bad_alloc();
         }
@@ -87,27 +97,27 @@ public:
     }
 
     explicit array(const array& other, const size_t offset, const size_t size)
-        : size_(size), array_(new T[size_]) {
+        : size_(size), array_(Allocator::allocate(size_)) {
         if (offset + size > other.size()) {
             throw std::out_of_range("array::array");
         }
         if (!array_) {
             throw std::bad_alloc();
         }
-        const size_t diff = size_ - size;
-        std::copy(other.begin() + static_cast<long>(offset),
-                  other.end() - static_cast<long>(diff), this->begin());
+        std::copy_n(other.begin() + static_cast<long>(offset), size_, this->begin());
     }
 
     array(array&& other) noexcept {
         array_ = other.array_;
         size_ = other.size_;
+        owner_ = other.owner_;
         other.array_ = nullptr;
         other.size_ = 0;
+        other.owner_ = true;
     }
 
     array(std::initializer_list<T> init_list)
-        : size_(init_list.size()), array_(new T[size_]) {
+        : size_(init_list.size()), array_(Allocator::allocate(size_)) {
         std::copy(init_list.begin(), init_list.end(), array_);
     }
 
@@ -128,17 +138,23 @@ public:
 
     array& operator=(array&& other) noexcept {
         if (this != &other) {
-            delete[] array_;
+            if (owner_) {
+                Allocator::deallocate(array_, size_);
+            }
             array_ = other.array_;
             size_ = other.size_;
+            owner_ = other.owner_;
             other.array_ = nullptr;
             other.size_ = 0;
+            other.owner_ = true;
         }
         return *this;
     }
 
     ~array() {
-        delete[] array_;
+        if (owner_) {
+            Allocator::deallocate(array_, size_);
+        }
     }
 
     Iterator begin() const { return Iterator(array_); }
@@ -151,6 +167,9 @@ public:
 
     [[nodiscard]] T* data() const { return array_; }
 
+    /// False for views (see array_view), which never free their memory
+    [[nodiscard]] bool owner() const { return owner_; }
+
     void clear() const {
         std::memset(array_, 0, size_ * sizeof(T));
     }
@@ -162,17 +181,33 @@ public:
         return array_[index];
     }
 
+protected:
+
+    struct borrow_t {};
+
+    /// Non-owning array over memory managed elsewhere, see array_view
+    array(T* data, const size_t size, borrow_t) : size_(size), array_(data), owner_(false) {}
+
 private:
 
     size_t size_;
 
     T* array_;
 
+    bool owner_ = true;
+
 };
 
 template<typename T>
 array(T, size_t) -> array<T>;
 
+/// Matches array and array_view, so generic single-value overloads can step aside for them
+template<typename T>
+struct is_mpi_array : std::false_type {};
+
+template<typename T, typename A>
+struct is_mpi_array<array<T, A>> : std::true_type {};
+
 
 }
 
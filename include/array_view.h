@@ -0,0 +1,75 @@
+#ifndef ARRAY_VIEW_H
+#define ARRAY_VIEW_H
+
+#include <ranges>
+#include <stdexcept>
+#include <type_traits>
+#include <array.h>
+
+
+
+namespace mpi {
+
+/// Non-owning array over existing contiguous memory (std::vector, std::span, std::array,
+/// mpi::array or any contiguous range). Since it is an array, every functor and collective
+/// accepts it without copying. The viewed memory must outlive every operation using it.
+template<typename T>
+class array_view : public array<T> {
+public:
+
+    array_view(T* data, const size_t size) : array<T>(data, size, typename array<T>::borrow_t{}) {}
+
+    /// Copies alias the same memory
+    array_view(const array_view& other) : array_view(other.data(), other.size()) {}
+
+    /// range must be writable, receives land in it, and borrowed, i.e. an lvalue or a view
+    template<std::ranges::contiguous_range R>
+    requires std::ranges::sized_range<R> && std::ranges::borrowed_range<R> &&
+        std::is_same_v<std::remove_reference_t<std::ranges::range_reference_t<R>>, T>
+    array_view(R&& range)
+        : array_view(std::ranges::data(range), std::ranges::size(range)) {}
+
+    template<std::ranges::contiguous_range R>
+    requires std::ranges::sized_range<R> && std::ranges::borrowed_range<R> &&
+        std::is_same_v<std::remove_reference_t<std::ranges::range_reference_t<R>>, T>
+    array_view(R&& range, const size_t offset, const size_t size)
+        : array_view(std::ranges::data(range) + checked(offset, size, std::ranges::size(range)), size) {}
+
+    template<typename A>
+    array_view(const array<T, A>& other) : array_view(other.data(), other.size()) {}
+
+    template<typename A>
+    array_view(const array<T, A>& other, const size_t offset, const size_t size)
+        : array_view(other.data() + checked(offset, size, other.size()), size) {}
+
+private:
+
+    static size_t checked(const size_t offset, const size_t size, const size_t total) {
+        if (offset + size > total) {
+            throw std::out_of_range("array_view::array_view");
+        }
+        return offset;
+    }
+
+};
+
+template<std::ranges::contiguous_range R>
+requires std::ranges::borrowed_range<R>
+array_view(R&&) -> array_view<std::ranges::range_value_t<R>>;
+
+template<std::ranges::contiguous_range R>
+requires std::ranges::borrowed_range<R>
+array_view(R&&, size_t, size_t) -> array_view<std::ranges::range_value_t<R>>;
+
+template<typename T, typename A>
+array_view(const array<T, A>&) -> array_view<T>;
+
+template<typename T, typename A>
+array_view(const array<T, A>&, size_t, size_t) -> array_view<T>;
+
+template<typename T>
+struct is_mpi_array<array_view<T>> : std::true_type {};
+
+}
+
+#endif //ARRAY_VIEW_H
@@ -0,0 +1,484 @@
+#ifndef LARGE_COUNT_H
+#define LARGE_COUNT_H
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include <mpi.h>
+
+
+
+namespace mpi {
+
+/// Largest count a classic int-count MPI call accepts
+inline constexpr size_t maxIntCount = INT_MAX;
+
+/// Broadcasts and scatters moving more bytes per rank than this are split into segments of
+/// pipelineSegment bytes with up to pipelineWindow of them in flight, so the hops of a tree
+/// overlap instead of forwarding the whole buffer one level at a time
+inline constexpr size_t pipelineThreshold = size_t{8} << 20;
+
+inline constexpr size_t pipelineSegment = size_t{1} << 20;
+
+inline constexpr size_t pipelineWindow = 8;
+
+/// count as an int, for the arguments MPI only takes as int (v-variant counts, displacements)
+inline int checkedCount(const size_t count) {
+    if (count > maxIntCount) {
+        throw std::overflow_error("mpi: count exceeds INT_MAX and the operation has no large-count form");
+    }
+    return static_cast<int>(count);
+}
+
+/// count elements of type as a single (int, datatype) pair. Counts up to INT_MAX pass through,
+/// larger ones become one element of a contiguous derived type that is freed with the object.
+/// MPI lets a datatype be freed while operations using it are pending.
+class LargeCount {
+public:
+
+    LargeCount(const size_t count, MPI_Datatype type) : type_(type) {
+        if (count <= maxIntCount) {
+            count_ = static_cast<int>(count);
+            return;
+        }
+        constexpr size_t block = size_t{1} << 30;
+        const size_t blocks = count / block;
+        const size_t rest = count % block;
+
+        MPI_Datatype chunk;
+        MPI_Type_contiguous(static_cast<int>(block), type, &chunk);
+        if (rest == 0) {
+            MPI_Type_contiguous(checkedCount(blocks), chunk, &type_);
+        } else {
+            MPI_Datatype body;
+            MPI_Type_contiguous(checkedCount(blocks), chunk, &body);
+            MPI_Aint lb;
+            MPI_Aint extent;
+            MPI_Type_get_extent(type, &lb, &extent);
+            MPI_Datatype tail;
+            MPI_Type_contiguous(static_cast<int>(rest), type, &tail);
+            const int lengths[2] = {1, 1};
+            const MPI_Aint displs[2] = {0, static_cast<MPI_Aint>(blocks * block) * extent};
+            const MPI_Datatype types[2] = {body, tail};
+            MPI_Type_create_struct(2, lengths, displs, types, &type_);
+            MPI_Type_free(&body);
+            MPI_Type_free(&tail);
+        }
+        MPI_Type_free(&chunk);
+        MPI_Type_commit(&type_);
+        count_ = 1;
+        owned_ = true;
+    }
+
+    LargeCount(const LargeCount& other) = delete;
+
+    LargeCount& operator=(const LargeCount& other) = delete;
+
+    ~LargeCount() {
+        if (owned_) {
+            MPI_Type_free(&type_);
+        }
+    }
+
+    [[nodiscard]] int count() const { return count_; }
+
+    [[nodiscard]] MPI_Datatype type() const { return type_; }
+
+private:
+
+    int count_ = 0;
+
+    MPI_Datatype type_;
+
+    bool owned_ = false;
+
+};
+
+/// Size_t-count forms of the MPI calls the wrapper issues. MPI-4 libraries get the _c functions,
+/// older ones a LargeCount derived type or, for reductions (which builtin ops only define on
+/// builtin types), a loop over INT_MAX sized chunks.
+namespace large {
+
+inline MPI_Aint extent(MPI_Datatype type) {
+    MPI_Aint lb;
+    MPI_Aint extent;
+    MPI_Type_get_extent(type, &lb, &extent);
+    return extent;
+}
+
+/// Runs f(offset, count) over [0, count) in chunks an int can hold
+template<typename Func>
+void chunked(const size_t count, Func&& f) {
+    constexpr size_t chunk = size_t{1} << 30;
+    if (count <= maxIntCount) {
+        f(size_t{0}, static_cast<int>(count));
+        return;
+    }
+    for (size_t offset = 0; offset < count; offset += chunk) {
+        f(offset, static_cast<int>(std::min(chunk, count - offset)));
+    }
+}
+
+inline const void* advance(const void* ptr, const size_t offset, MPI_Datatype type) {
+    return ptr == MPI_IN_PLACE || ptr == nullptr ? ptr
+        : static_cast<const char*>(ptr) + static_cast<MPI_Aint>(offset) * extent(type);
+}
+
+inline void* advance(void* ptr, const size_t offset, MPI_Datatype type) {
+    return ptr == nullptr ? ptr : static_cast<char*>(ptr) + static_cast<MPI_Aint>(offset) * extent(type);
+}
+
+inline void send(const void* buffer, const size_t count, MPI_Datatype type, const int dest, const int tag,
+                 MPI_Comm comm) {
+#if MPI_VERSION >= 4
+    MPI_Send_c(buffer, static_cast<MPI_Count>(count), type, dest, tag, comm);
+#else
+    const LargeCount large(count, type);
+    MPI_Send(buffer, large.count(), large.type(), dest, tag, comm);
+#endif
+}
+
+inline void recv(void* buffer, const size_t count, MPI_Datatype type, const int source, const int tag,
+                 MPI_Comm comm) {
+#if MPI_VERSION >= 4
+    MPI_Recv_c(buffer, static_cast<MPI_Count>(count), type, source, tag, comm, MPI_STATUS_IGNORE);
+#else
+    const LargeCount large(count, type);
+    MPI_Recv(buffer, large.count(), large.type(), source, tag, comm, MPI_STATUS_IGNORE);
+#endif
+}
+
+/// Receives a message matched by MPI_Mprobe/MPI_Improbe
+inline void mrecv(void* buffer, const size_t count, MPI_Datatype type, MPI_Message* message) {
+#if MPI_VERSION >= 4
+    MPI_Mrecv_c(buffer, static_cast<MPI_Count>(count), type, message, MPI_STATUS_IGNORE);
+#else
+    const LargeCount large(count, type);
+    MPI_Mrecv(buffer, large.count(), large.type(), message, MPI_STATUS_IGNORE);
+#endif
+}
+
+/// Elements of type in the message status describes. Before MPI-4 the count is derived from the
+/// basic elements, of which every element of type holds basicElements. Throws when the message
+/// is not a whole number of elements.
+inline size_t getCount(const MPI_Status& status, MPI_Datatype type, const size_t basicElements = 1) {
+    MPI_Count count;
+#if MPI_VERSION >= 4
+    MPI_Get_count_c(&status, type, &count);
+#else
+    MPI_Get_elements_x(&status, type, &count);
+    if (count != MPI_UNDEFINED) {
+        count = static_cast<size_t>(count) % basicElements == 0
+            ? static_cast<MPI_Count>(static_cast<size_t>(count) / basicElements) : MPI_UNDEFINED;
+    }
+#endif
+    if (count == MPI_UNDEFINED || count < 0) {
+        throw std::runtime_error("mpi: message is not a whole number of elements");
+    }
+    return static_cast<size_t>(count);
+}
+
+inline void isend(const void* buffer, const size_t count, MPI_Datatype type, const int dest, const int tag,
+                  MPI_Comm comm, MPI_Request* request) {
+#if MPI_VERSION >= 4
+    MPI_Isend_c(buffer, static_cast<MPI_Count>(count), type, dest, tag, comm, request);
+#else
+    const LargeCount large(count, type);
+    MPI_Isend(buffer, large.count(), large.type(), dest, tag, comm, request);
+#endif
+}
+
+inline void irecv(void* buffer, const size_t count, MPI_Datatype type, const int source, const int tag,
+                  MPI_Comm comm, MPI_Request* request) {
+#if MPI_VERSION >= 4
+    MPI_Irecv_c(buffer, static_cast<MPI_Count>(count), type, source, tag, comm, request);
+#else
+    const LargeCount large(count, type);
+    MPI_Irecv(buffer, large.count(), large.type(), source, tag, comm, request);
+#endif
+}
+
+inline void sendInit(const void* buffer, const size_t count, MPI_Datatype type, const int dest, const int tag,
+                     MPI_Comm comm, MPI_Request* request) {
+#if MPI_VERSION >= 4
+    MPI_Send_init_c(buffer, static_cast<MPI_Count>(count), type, dest, tag, comm, request);
+#else
+    const LargeCount large(count, type);
+    MPI_Send_init(buffer, large.count(), large.type(), dest, tag, comm, request);
+#endif
+}
+
+inline void recvInit(void* buffer, const size_t count, MPI_Datatype type, const int source, const int tag,
+                     MPI_Comm comm, MPI_Request* request) {
+#if MPI_VERSION >= 4
+    MPI_Recv_init_c(buffer, static_cast<MPI_Count>(count), type, source, tag, comm, request);
+#else
+    const LargeCount large(count, type);
+    MPI_Recv_init(buffer, large.count(), large.type(), source, tag, comm, request);
+#endif
+}
+
+inline void ibcast(void* buffer, const size_t count, MPI_Datatype type, const int root, MPI_Comm comm,
+                   MPI_Request* request) {
+#if MPI_VERSION >= 4
+    MPI_Ibcast_c(buffer, static_cast<MPI_Count>(count), type, root, comm, request);
+#else
+    const LargeCount large(count, type);
+    MPI_Ibcast(buffer, large.count(), large.type(), root, comm, request);
+#endif
+}
+
+/// Segments above pipelineThreshold bytes into pipelined non-blocking broadcasts
+inline void bcast(void* buffer, const size_t count, MPI_Datatype type, const int root, MPI_Comm comm) {
+    int commSize;
+    MPI_Comm_size(comm, &commSize);
+    const auto bytes = static_cast<size_t>(extent(type)) * count;
+    if (commSize <= 2 || bytes <= pipelineThreshold) {
+#if MPI_VERSION >= 4
+        MPI_Bcast_c(buffer, static_cast<MPI_Count>(count), type, root, comm);
+#else
+        const LargeCount large(count, type);
+        MPI_Bcast(buffer, large.count(), large.type(), root, comm);
+#endif
+        return;
+    }
+    const size_t segment = std::max<size_t>(pipelineSegment / static_cast<size_t>(extent(type)), 1);
+    std::vector<MPI_Request> requests;
+    requests.reserve(pipelineWindow);
+    for (size_t offset = 0; offset < count; offset += segment) {
+        if (requests.size() == pipelineWindow) {
+            MPI_Wait(&requests.front(), MPI_STATUS_IGNORE);
+            requests.erase(requests.begin());
+        }
+        requests.emplace_back();
+        MPI_Ibcast(advance(buffer, offset, type), static_cast<int>(std::min(segment, count - offset)), type,
+                   root, comm, &requests.back());
+    }
+    MPI_Waitall(static_cast<int>(requests.size()), requests.data(), MPI_STATUSES_IGNORE);
+}
+
+inline void iscatter(const void* send, void* recv, const size_t count, MPI_Datatype type, const int root,
+                     MPI_Comm comm, MPI_Request* request) {
+#if MPI_VERSION >= 4
+    MPI_Iscatter_c(send, static_cast<MPI_Count>(count), type, recv, static_cast<MPI_Count>(count), type,
+                   root, comm, request);
+#else
+    const LargeCount large(count, type);
+    MPI_Iscatter(send, large.count(), large.type(), recv, large.count(), large.type(), root, comm, request);
+#endif
+}
+
+/// count elements to every rank. Above pipelineThreshold bytes per rank, every rank's block is
+/// cut into segments sent by pipelined non-blocking scatters of a type resized to the block.
+inline void scatter(const void* send, void* recv, const size_t count, MPI_Datatype type, const int root,
+                    MPI_Comm comm) {
+    const MPI_Aint typeExtent = extent(type);
+    const auto bytes = static_cast<size_t>(typeExtent) * count;
+    if (bytes <= pipelineThreshold) {
+#if MPI_VERSION >= 4
+        MPI_Scatter_c(send, static_cast<MPI_Count>(count), type, recv, static_cast<MPI_Count>(count), type,
+                      root, comm);
+#else
+        const LargeCount large(count, type);
+        MPI_Scatter(send, large.count(), large.type(), recv, large.count(), large.type(), root, comm);
+#endif
+        return;
+    }
+    const size_t segment = std::max<size_t>(pipelineSegment / static_cast<size_t>(typeExtent), 1);
+    std::vector<MPI_Request> requests;
+    requests.reserve(pipelineWindow);
+    for (size_t offset = 0; offset < count; offset += segment) {
+        if (requests.size() == pipelineWindow) {
+            MPI_Wait(&requests.front(), MPI_STATUS_IGNORE);
+            requests.erase(requests.begin());
+        }
+        const int length = static_cast<int>(std::min(segment, count - offset));
+        // Segment of one block, strided by the whole block between ranks
+        MPI_Datatype piece;
+        MPI_Datatype strided;
+        MPI_Type_contiguous(length, type, &piece);
+        MPI_Type_create_resized(piece, 0, static_cast<MPI_Aint>(count) * typeExtent, &strided);
+        MPI_Type_commit(&strided);
+        requests.emplace_back();
+        MPI_Iscatter(advance(send, offset, type), 1, strided, advance(recv, offset, type), length, type,
+                     root, comm, &requests.back());
+        MPI_Type_free(&strided);
+        MPI_Type_free(&piece);
+    }
+    MPI_Waitall(static_cast<int>(requests.size()), requests.data(), MPI_STATUSES_IGNORE);
+}
+
+inline void gather(const void* send, const size_t sendCount, void* recv, const size_t recvCount,
+                   MPI_Datatype type, const int root, MPI_Comm comm) {
+#if MPI_VERSION >= 4
+    MPI_Gather_c(send, static_cast<MPI_Count>(sendCount), type, recv, static_cast<MPI_Count>(recvCount), type,
+                 root, comm);
+#else
+    const LargeCount sent(sendCount, type);
+    const LargeCount received(recvCount, type);
+    MPI_Gather(send, sent.count(), sent.type(), recv, received.count(), received.type(), root, comm);
+#endif
+}
+
+inline void igather(const void* send, void* recv, const size_t count, MPI_Datatype type, const int root,
+                    MPI_Comm comm, MPI_Request* request) {
+#if MPI_VERSION >= 4
+    MPI_Igather_c(send, static_cast<MPI_Count>(count), type, recv, static_cast<MPI_Count>(count), type,
+                  root, comm, request);
+#else
+    const LargeCount large(count, type);
+    MPI_Igather(send, large.count(), large.type(), recv, large.count(), large.type(), root, comm, request);
+#endif
+}
+
+inline void allGather(const void* send, const size_t sendCount, void* recv, const size_t recvCount,
+                      MPI_Datatype type, MPI_Comm comm) {
+#if MPI_VERSION >= 4
+    MPI_Allgather_c(send, static_cast<MPI_Count>(sendCount), type, recv, static_cast<MPI_Count>(recvCount), type,
+                    comm);
+#else
+    const LargeCount sent(sendCount, type);
+    const LargeCount received(recvCount, type);
+    MPI_Allgather(send, sent.count(), sent.type(), recv, received.count(), received.type(), comm);
+#endif
+}
+
+inline void iallGather(const void* send, void* recv, const size_t count, MPI_Datatype type, MPI_Comm comm,
+                       MPI_Request* request) {
+#if MPI_VERSION >= 4
+    MPI_Iallgather_c(send, static_cast<MPI_Count>(count), type, recv, static_cast<MPI_Count>(count), type,
+                     comm, request);
+#else
+    const LargeCount large(count, type);
+    MPI_Iallgather(send, large.count(), large.type(), recv, large.count(), large.type(), comm, request);
+#endif
+}
+
+inline void allToAll(const void* send, void* recv, const size_t count, MPI_Datatype type, MPI_Comm comm) {
+#if MPI_VERSION >= 4
+    MPI_Alltoall_c(send, static_cast<MPI_Count>(count), type, recv, static_cast<MPI_Count>(count), type, comm);
+#else
+    const LargeCount large(count, type);
+    MPI_Alltoall(send, large.count(), large.type(), recv, large.count(), large.type(), comm);
+#endif
+}
+
+inline void iallToAll(const void* send, void* recv, const size_t count, MPI_Datatype type, MPI_Comm comm,
+                      MPI_Request* request) {
+#if MPI_VERSION >= 4
+    MPI_Ialltoall_c(send, static_cast<MPI_Count>(count), type, recv, static_cast<MPI_Count>(count), type,
+                    comm, request);
+#else
+    const LargeCount large(count, type);
+    MPI_Ialltoall(send, large.count(), large.type(), recv, large.count(), large.type(), comm, request);
+#endif
+}
+
+inline void reduce(const void* send, void* recv, const size_t count, MPI_Datatype type, MPI_Op op,
+                   const int root, MPI_Comm comm) {
+#if MPI_VERSION >= 4
+    MPI_Reduce_c(send, recv, static_cast<MPI_Count>(count), type, op, root, comm);
+#else
+    chunked(count, [&](const size_t offset, const int length) {
+        MPI_Reduce(advance(send, offset, type), advance(recv, offset, type), length, type, op, root, comm);
+    });
+#endif
+}
+
+inline void allReduce(const void* send, void* recv, const size_t count, MPI_Datatype type, MPI_Op op,
+                      MPI_Comm comm) {
+#if MPI_VERSION >= 4
+    MPI_Allreduce_c(send, recv, static_cast<MPI_Count>(count), type, op, comm);
+#else
+    chunked(count, [&](const size_t offset, const int length) {
+        MPI_Allreduce(advance(send, offset, type), advance(recv, offset, type), length, type, op, comm);
+    });
+#endif
+}
+
+inline void scan(const void* send, void* recv, const size_t count, MPI_Datatype type, MPI_Op op,
+                 MPI_Comm comm) {
+#if MPI_VERSION >= 4
+    MPI_Scan_c(send, recv, static_cast<MPI_Count>(count), type, op, comm);
+#else
+    chunked(count, [&](const size_t offset, const int length) {
+        MPI_Scan(advance(send, offset, type), advance(recv, offset, type), length, type, op, comm);
+    });
+#endif
+}
+
+
+/// One-sided transfers. Unlike the collective reductions, accumulate accepts derived types built
+/// from a single predefined type, so the LargeCount type serves both sides of every call.
+inline void put(const void* origin, const size_t count, MPI_Datatype type, const int target, const MPI_Aint disp,
+                MPI_Win win) {
+#if MPI_VERSION >= 4
+    MPI_Put_c(origin, static_cast<MPI_Count>(count), type, target, disp, static_cast<MPI_Count>(count), type, win);
+#else
+    const LargeCount large(count, type);
+    MPI_Put(origin, large.count(), large.type(), target, disp, large.count(), large.type(), win);
+#endif
+}
+
+inline void get(void* origin, const size_t count, MPI_Datatype type, const int target, const MPI_Aint disp,
+                MPI_Win win) {
+#if MPI_VERSION >= 4
+    MPI_Get_c(origin, static_cast<MPI_Count>(count), type, target, disp, static_cast<MPI_Count>(count), type, win);
+#else
+    const LargeCount large(count, type);
+    MPI_Get(origin, large.count(), large.type(), target, disp, large.count(), large.type(), win);
+#endif
+}
+
+inline void accumulate(const void* origin, const size_t count, MPI_Datatype type, const int target,
+                       const MPI_Aint disp, MPI_Op op, MPI_Win win) {
+#if MPI_VERSION >= 4
+    MPI_Accumulate_c(origin, static_cast<MPI_Count>(count), type, target, disp, static_cast<MPI_Count>(count),
+                     type, op, win);
+#else
+    const LargeCount large(count, type);
+    MPI_Accumulate(origin, large.count(), large.type(), target, disp, large.count(), large.type(), op, win);
+#endif
+}
+
+inline void rput(const void* origin, const size_t count, MPI_Datatype type, const int target, const MPI_Aint disp,
+                 MPI_Win win, MPI_Request* request) {
+#if MPI_VERSION >= 4
+    MPI_Rput_c(origin, static_cast<MPI_Count>(count), type, target, disp, static_cast<MPI_Count>(count), type, win,
+               request);
+#else
+    const LargeCount large(count, type);
+    MPI_Rput(origin, large.count(), large.type(), target, disp, large.count(), large.type(), win, request);
+#endif
+}
+
+inline void rget(void* origin, const size_t count, MPI_Datatype type, const int target, const MPI_Aint disp,
+                 MPI_Win win, MPI_Request* request) {
+#if MPI_VERSION >= 4
+    MPI_Rget_c(origin, static_cast<MPI_Count>(count), type, target, disp, static_cast<MPI_Count>(count), type, win,
+               request);
+#else
+    const LargeCount large(count, type);
+    MPI_Rget(origin, large.count(), large.type(), target, disp, large.count(), large.type(), win, request);
+#endif
+}
+
+inline void raccumulate(const void* origin, const size_t count, MPI_Datatype type, const int target,
+                        const MPI_Aint disp, MPI_Op op, MPI_Win win, MPI_Request* request) {
+#if MPI_VERSION >= 4
+    MPI_Raccumulate_c(origin, static_cast<MPI_Count>(count), type, target, disp, static_cast<MPI_Count>(count),
+                      type, op, win, request);
+#else
+    const LargeCount large(count, type);
+    MPI_Raccumulate(origin, large.count(), large.type(), target, disp, large.count(), large.type(), op, win,
+                    request);
+#endif
+}
+
+}
+
+}
+
+#endif //LARGE_COUNT_H
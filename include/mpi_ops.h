@@ -0,0 +1,39 @@
+#ifndef MPI_OPS_H
+#define MPI_OPS_H
+
+#include <mpi.h>
+#include <type_traits>
+#include <mpi_types.h>
+
+
+/// Reduction kernel handed to MPI_Op_create. MPI guarantees invec and inoutvec do not overlap,
+/// so the loop is a plain element-wise map the compiler is free to vectorize.
+template<typename T, typename Func>
+void reduce_kernel(void* invec, void* inoutvec, int* len, MPI_Datatype*) {
+    const T* __restrict in = static_cast<const T*>(invec);
+    T* __restrict inout = static_cast<T*>(inoutvec);
+    const Func func{};
+    const int n = *len;
+    for (int i = 0; i < n; ++i) {
+        inout[i] = func(in[i], inout[i]);
+    }
+}
+
+/// Creates the MPI_Op for a captureless binary lambda once per (T, Func, Commute)
+template<typename T, typename Func, bool Commute = true>
+MPI_Op get_mpi_op() {
+    static_assert(is_mpi_type<T>::value,
+        "get_mpi_op: custom reductions need an mpi type, describe structs with mpi_fields<T>");
+    static_assert(std::is_empty_v<Func> && std::is_default_constructible_v<Func>,
+        "get_mpi_op: reduction lambdas must not capture");
+    static_assert(std::is_invocable_r_v<T, const Func&, const T&, const T&>,
+        "get_mpi_op: reduction must be callable as T(const T&, const T&)");
+    static const MPI_Op op = [] {
+        MPI_Op created;
+        MPI_Op_create(&reduce_kernel<T, Func>, Commute ? 1 : 0, &created);
+        return created;
+    }();
+    return op;
+}
+
+#endif //MPI_OPS_H
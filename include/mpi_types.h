@@ -1,26 +1,60 @@
 #ifndef HELPERMAPMPI_H
 #define HELPERMAPMPI_H
 
+#include <array>
+#include <cstddef>
 #include <mpi.h>
+#include <tuple>
+#include <type_traits>
+
+
+/// Describes the members of a struct so it is sent as a derived MPI datatype instead of
+/// raw MPI_BYTE. Specialise with a tuple of member pointers, e.g.
+///
+///     template<> struct mpi_fields<Particle> {
+///         static constexpr auto value = std::make_tuple(&Particle::pos, &Particle::mass);
+///     };
+///
+/// Members must be mpi types themselves (nested described structs and C arrays included).
+template<typename T>
+struct mpi_fields {};
 
+template<typename T, typename = void>
+struct has_mpi_fields : std::false_type {};
 
-template<typename>
-struct is_mpi_type : std::false_type {};
+template<typename T>
+struct has_mpi_fields<T, std::void_t<decltype(mpi_fields<T>::value)>> : std::true_type {};
 
-template<> struct is_mpi_type<char> : std::true_type {};
-template<> struct is_mpi_type<unsigned char> : std::true_type {};
-template<> struct is_mpi_type<short> : std::true_type {};
-template<> struct is_mpi_type<unsigned short> : std::true_type {};
-template<> struct is_mpi_type<int> : std::true_type {};
-template<> struct is_mpi_type<unsigned int> : std::true_type {};
-template<> struct is_mpi_type<long> : std::true_type {};
-template<> struct is_mpi_type<unsigned long> : std::true_type {};
-template<> struct is_mpi_type<long long> : std::true_type {};
-template<> struct is_mpi_type<float> : std::true_type {};
-template<> struct is_mpi_type<double> : std::true_type {};
+/// Types with a predefined MPI datatype, the only ones the predefined reduction ops (MPI_SUM, ...) accept
+template<typename T>
+struct is_builtin_mpi_type : std::false_type {};
+
+template<> struct is_builtin_mpi_type<char> : std::true_type {};
+template<> struct is_builtin_mpi_type<unsigned char> : std::true_type {};
+template<> struct is_builtin_mpi_type<short> : std::true_type {};
+template<> struct is_builtin_mpi_type<unsigned short> : std::true_type {};
+template<> struct is_builtin_mpi_type<int> : std::true_type {};
+template<> struct is_builtin_mpi_type<unsigned int> : std::true_type {};
+template<> struct is_builtin_mpi_type<long> : std::true_type {};
+template<> struct is_builtin_mpi_type<unsigned long> : std::true_type {};
+template<> struct is_builtin_mpi_type<long long> : std::true_type {};
+template<> struct is_builtin_mpi_type<float> : std::true_type {};
+template<> struct is_builtin_mpi_type<double> : std::true_type {};
+
+/// Types that can be transported as themselves rather than as raw bytes, builtins and described structs
+template<typename T>
+struct is_mpi_type : std::disjunction<is_builtin_mpi_type<T>, has_mpi_fields<T>> {};
 
 template<typename T>
-MPI_Datatype get_mpi_type();
+MPI_Datatype create_struct_type();
+
+/// Builds and commits the datatype of a struct described by mpi_fields once per type
+template<typename T>
+MPI_Datatype get_mpi_type() {
+    static_assert(has_mpi_fields<T>::value, "get_mpi_type: specialise mpi_fields<T> to describe T");
+    static const MPI_Datatype type = create_struct_type<T>();
+    return type;
+}
 
 template<>
 inline MPI_Datatype get_mpi_type<char>() { return MPI_CHAR; }
@@ -55,4 +89,63 @@ inline MPI_Datatype get_mpi_type<float>() { return MPI_FLOAT; }
 template<>
 inline MPI_Datatype get_mpi_type<double>() { return MPI_DOUBLE; }
 
+template<typename T, typename M>
+void describe_field(const T& probe, M T::* member, const MPI_Aint base,
+                    int& length, MPI_Aint& displacement, MPI_Datatype& type) {
+    using E = std::remove_all_extents_t<M>;
+    length = static_cast<int>(sizeof(M) / sizeof(E));
+    MPI_Get_address(&(probe.*member), &displacement);
+    displacement = MPI_Aint_diff(displacement, base);
+    type = get_mpi_type<E>();
+}
+
+template<typename T>
+constexpr size_t basic_element_count();
+
+template<typename T, typename M>
+constexpr size_t field_basic_element_count(M T::*) {
+    using E = std::remove_all_extents_t<M>;
+    return sizeof(M) / sizeof(E) * basic_element_count<E>();
+}
+
+/// Predefined elements making up one T, what MPI_Get_elements counts per value
+template<typename T>
+constexpr size_t basic_element_count() {
+    if constexpr (is_builtin_mpi_type<T>::value) {
+        return 1;
+    } else {
+        return std::apply([](auto... member) {
+            return (size_t{0} + ... + field_basic_element_count(member));
+        }, mpi_fields<T>::value);
+    }
+}
+
+template<typename T>
+MPI_Datatype create_struct_type() {
+    constexpr auto& fields = mpi_fields<T>::value;
+    constexpr size_t count = std::tuple_size_v<std::remove_cvref_t<decltype(fields)>>;
+
+    std::array<int, count> lengths{};
+    std::array<MPI_Aint, count> displacements{};
+    std::array<MPI_Datatype, count> types{};
+
+    const T probe{};
+    MPI_Aint base;
+    MPI_Get_address(&probe, &base);
+
+    size_t i = 0;
+    std::apply([&](auto... member) {
+        ((describe_field(probe, member, base, lengths[i], displacements[i], types[i]), ++i), ...);
+    }, fields);
+
+    // Resize to sizeof(T) so trailing padding is respected when sending arrays of T
+    MPI_Datatype packed;
+    MPI_Datatype type;
+    MPI_Type_create_struct(static_cast<int>(count), lengths.data(), displacements.data(), types.data(), &packed);
+    MPI_Type_create_resized(packed, 0, static_cast<MPI_Aint>(sizeof(T)), &type);
+    MPI_Type_free(&packed);
+    MPI_Type_commit(&type);
+    return type;
+}
+
 #endif //HELPERMAPMPI_H
@@ -0,0 +1,110 @@
+#ifndef SHARED_ARRAY_H
+#define SHARED_ARRAY_H
+
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <mpi.h>
+#include <Communicator.h>
+#include <array.h>
+#include <array_view.h>
+
+
+
+namespace mpi {
+
+/// One array per node, allocated by the first rank of a shared-memory communicator
+/// (see Communicator::splitShared()) with MPI_Win_allocate_shared and mapped zero-copy
+/// into every rank of it. Construction and destruction are collective over that communicator.
+/// Separate writes from reads with fence().
+template<typename T>
+class shared_array {
+public:
+
+    static_assert(std::is_trivially_copyable_v<T>, "shared_array: T must be trivially copyable");
+
+    using value_type = T;
+
+    using Iterator = typename array<T>::Iterator;
+
+    shared_array(std::shared_ptr<Communicator> node, const size_t size)
+        : node_(std::move(node)), size_(size) {
+        const bool owner = node_->rank() == 0;
+        T* base = nullptr;
+        if (MPI_Win_allocate_shared(static_cast<MPI_Aint>(owner ? size_ * sizeof(T) : 0),
+                                    static_cast<int>(sizeof(T)), MPI_INFO_NULL, node_->get(),
+                                    &base, &window_) != MPI_SUCCESS) {
+            throw std::runtime_error("MPI_Win_allocate_shared failed");
+        }
+        MPI_Aint bytes;
+        int unit;
+        MPI_Win_shared_query(window_, 0, &bytes, &unit, &array_);
+        if (owner) {
+            std::uninitialized_value_construct_n(array_, size_);
+        }
+        fence();
+    }
+
+    shared_array(const shared_array& other) = delete;
+
+    shared_array(shared_array&& other) noexcept
+        : node_(std::move(other.node_)), size_(other.size_), array_(other.array_), window_(other.window_) {
+        other.size_ = 0;
+        other.array_ = nullptr;
+        other.window_ = MPI_WIN_NULL;
+    }
+
+    shared_array& operator=(const shared_array& other) = delete;
+
+    ~shared_array() {
+        int finalized = 0;
+        MPI_Finalized(&finalized);
+        if (window_ != MPI_WIN_NULL && !finalized) {
+            MPI_Win_free(&window_);
+        }
+    }
+
+    /// Completes all writes before any rank of the node reads
+    void fence() const {
+        MPI_Win_fence(0, window_);
+    }
+
+    /// Non-owning array over the node copy, accepted by every operation
+    [[nodiscard]] array_view<T> view() const { return array_view<T>(array_, size_); }
+
+    Iterator begin() const { return Iterator(array_); }
+
+    Iterator end() const { return Iterator(array_ + size_); }
+
+    [[nodiscard]] size_t size() const { return size_; }
+
+    [[nodiscard]] bool empty() const { return size_ == 0; }
+
+    [[nodiscard]] T* data() const { return array_; }
+
+    [[nodiscard]] MPI_Win window() const { return window_; }
+
+    [[nodiscard]] const std::shared_ptr<Communicator>& communicator() const { return node_; }
+
+    T& operator[](const size_t index) const {
+        if (index >= size_) {
+            throw std::out_of_range("shared_array::operator[]");
+        }
+        return array_[index];
+    }
+
+private:
+
+    std::shared_ptr<Communicator> node_;
+
+    size_t size_;
+
+    T* array_ = nullptr;
+
+    MPI_Win window_ = MPI_WIN_NULL;
+
+};
+
+}
+
+#endif //SHARED_ARRAY_H
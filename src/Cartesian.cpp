@@ -0,0 +1,106 @@
+#include <Cartesian.h>
+
+#include <stdexcept>
+
+
+
+namespace mpi {
+
+Cartesian::Cartesian(const Communicator& parent, std::vector<int> dims, const std::vector<bool>& periods,
+                     const bool reorder)
+    : dims_(std::move(dims)), periods_(periods) {
+    if (dims_.empty() || periods_.size() != dims_.size()) {
+        throw std::invalid_argument("Cartesian: need one period flag per dimension");
+    }
+    // Checked up front, every rank comes to the same verdict before any collective call
+    int fixed = 1;
+    bool free = false;
+    for (const int dim : dims_) {
+        if (dim < 0) {
+            throw std::invalid_argument("Cartesian: negative dimension");
+        }
+        free = free || dim == 0;
+        fixed *= dim == 0 ? 1 : dim;
+    }
+    if (free ? parent.size() % fixed != 0 : parent.size() != fixed) {
+        throw std::invalid_argument("Cartesian: the grid must cover every rank of the communicator");
+    }
+    const int ndims = static_cast<int>(dims_.size());
+    MPI_Dims_create(parent.size(), ndims, dims_.data());
+    const std::vector<int> cyclic(periods_.begin(), periods_.end());
+    MPI_Comm comm;
+    if (MPI_Cart_create(parent.get(), ndims, dims_.data(), cyclic.data(), reorder ? 1 : 0, &comm) != MPI_SUCCESS) {
+        throw std::runtime_error("MPI_Cart_create failed");
+    }
+    comm_ = std::make_shared<Communicator>(comm, true);
+    coords_ = coords(comm_->rank());
+}
+
+Cartesian::Cartesian(const Communicator& parent, std::vector<int> dims)
+    : Cartesian(parent, dims, std::vector<bool>(dims.size(), false)) {}
+
+std::shared_ptr<Communicator> Cartesian::communicator() const {
+    return comm_;
+}
+
+MPI_Comm Cartesian::get() const {
+    return comm_->get();
+}
+
+int Cartesian::rank() const {
+    return comm_->rank();
+}
+
+int Cartesian::size() const {
+    return comm_->size();
+}
+
+int Cartesian::ndims() const {
+    return static_cast<int>(dims_.size());
+}
+
+const std::vector<int>& Cartesian::dims() const {
+    return dims_;
+}
+
+const std::vector<bool>& Cartesian::periods() const {
+    return periods_;
+}
+
+const std::vector<int>& Cartesian::coords() const {
+    return coords_;
+}
+
+std::vector<int> Cartesian::coords(const int rank) const {
+    std::vector<int> coords(dims_.size());
+    MPI_Cart_coords(comm_->get(), rank, ndims(), coords.data());
+    return coords;
+}
+
+int Cartesian::rankAt(std::vector<int> coords) const {
+    if (coords.size() != dims_.size()) {
+        throw std::invalid_argument("Cartesian::rankAt: wrong number of coordinates");
+    }
+    for (size_t d = 0; d < dims_.size(); ++d) {
+        if (periods_[d]) {
+            coords[d] = (coords[d] % dims_[d] + dims_[d]) % dims_[d];
+        } else if (coords[d] < 0 || coords[d] >= dims_[d]) {
+            return MPI_PROC_NULL;
+        }
+    }
+    int rank;
+    MPI_Cart_rank(comm_->get(), coords.data(), &rank);
+    return rank;
+}
+
+std::pair<int, int> Cartesian::shift(const int dim, const int disp) const {
+    if (dim < 0 || dim >= ndims()) {
+        throw std::out_of_range("Cartesian::shift");
+    }
+    int source;
+    int dest;
+    MPI_Cart_shift(comm_->get(), dim, disp, &source, &dest);
+    return {source, dest};
+}
+
+}
@@ -0,0 +1,89 @@
+#include <Communicator.h>
+
+#include <stdexcept>
+
+
+
+namespace mpi {
+
+Communicator::Communicator(MPI_Comm comm, const bool owned)
+    : comm_(comm), owned_(owned), rank_(0), size_(0) {
+    if (comm_ == MPI_COMM_NULL) {
+        throw std::invalid_argument("Communicator: MPI_COMM_NULL");
+    }
+    MPI_Comm_rank(comm_, &rank_);
+    MPI_Comm_size(comm_, &size_);
+}
+
+Communicator::~Communicator() {
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+    if (owned_ && !finalized) {
+        MPI_Comm_free(&comm_);
+    }
+}
+
+std::shared_ptr<Communicator> Communicator::world() {
+    return std::make_shared<Communicator>(MPI_COMM_WORLD, false);
+}
+
+std::shared_ptr<Communicator> Communicator::split(const int color, const int key) const {
+    MPI_Comm comm;
+    if (MPI_Comm_split(comm_, color, key, &comm) != MPI_SUCCESS) {
+        throw std::runtime_error("MPI_Comm_split failed");
+    }
+    if (comm == MPI_COMM_NULL) {
+        return nullptr;
+    }
+    return std::make_shared<Communicator>(comm, true);
+}
+
+std::shared_ptr<Communicator> Communicator::dup() const {
+    MPI_Comm comm;
+    if (MPI_Comm_dup(comm_, &comm) != MPI_SUCCESS) {
+        throw std::runtime_error("MPI_Comm_dup failed");
+    }
+    auto copy = std::make_shared<Communicator>(comm, true);
+    copy->root_ = root_;
+    return copy;
+}
+
+std::shared_ptr<Communicator> Communicator::splitShared() const {
+    MPI_Comm comm;
+    if (MPI_Comm_split_type(comm_, MPI_COMM_TYPE_SHARED, rank_, MPI_INFO_NULL, &comm) != MPI_SUCCESS) {
+        throw std::runtime_error("MPI_Comm_split_type failed");
+    }
+    return std::make_shared<Communicator>(comm, true);
+}
+
+int Communicator::nodeSize() const {
+    if (nodeSize_ == 0) {
+        nodeSize_ = splitShared()->size();
+    }
+    return nodeSize_;
+}
+
+MPI_Comm Communicator::get() const {
+    return comm_;
+}
+
+int Communicator::rank() const {
+    return rank_;
+}
+
+int Communicator::size() const {
+    return size_;
+}
+
+int Communicator::root() const {
+    return root_;
+}
+
+void Communicator::setRoot(const int root) {
+    if (root < 0 || root >= size_) {
+        throw std::out_of_range("Communicator::setRoot");
+    }
+    root_ = root;
+}
+
+}
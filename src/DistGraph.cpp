@@ -0,0 +1,85 @@
+#include <DistGraph.h>
+
+#include <stdexcept>
+
+
+
+namespace mpi {
+
+namespace {
+
+/// Weights argument for one direction, MPI distinguishes unweighted from weighted with no edges
+const int* weightsOf(const std::vector<int>& weights, const size_t degree, const bool weighted) {
+    if (!weighted) {
+        return MPI_UNWEIGHTED;
+    }
+    if (weights.size() != degree) {
+        throw std::invalid_argument("DistGraph: need one weight per edge");
+    }
+    return degree == 0 ? MPI_WEIGHTS_EMPTY : weights.data();
+}
+
+}
+
+DistGraph::DistGraph(const Communicator& parent, const std::vector<int>& sources,
+                     const std::vector<int>& destinations, const std::vector<int>& sourceWeights,
+                     const std::vector<int>& destinationWeights, const bool reorder) {
+    const bool weighted = !sourceWeights.empty() || !destinationWeights.empty();
+    const int* inWeights = weightsOf(sourceWeights, sources.size(), weighted);
+    const int* outWeights = weightsOf(destinationWeights, destinations.size(), weighted);
+    MPI_Comm comm;
+    if (MPI_Dist_graph_create_adjacent(parent.get(),
+                                       static_cast<int>(sources.size()), sources.data(), inWeights,
+                                       static_cast<int>(destinations.size()), destinations.data(), outWeights,
+                                       MPI_INFO_NULL, reorder ? 1 : 0, &comm) != MPI_SUCCESS) {
+        throw std::runtime_error("MPI_Dist_graph_create_adjacent failed");
+    }
+    comm_ = std::make_shared<Communicator>(comm, true);
+
+    // Neighbours as numbered in the new communicator
+    sources_.resize(sources.size());
+    destinations_.resize(destinations.size());
+    std::vector<int> inIgnored(sources.size());
+    std::vector<int> outIgnored(destinations.size());
+    MPI_Dist_graph_neighbors(comm, static_cast<int>(sources_.size()), sources_.data(),
+                             weighted ? inIgnored.data() : MPI_UNWEIGHTED,
+                             static_cast<int>(destinations_.size()), destinations_.data(),
+                             weighted ? outIgnored.data() : MPI_UNWEIGHTED);
+}
+
+DistGraph::DistGraph(const Communicator& parent, const std::vector<int>& neighbors, const bool reorder)
+    : DistGraph(parent, neighbors, neighbors, {}, {}, reorder) {}
+
+std::shared_ptr<Communicator> DistGraph::communicator() const {
+    return comm_;
+}
+
+MPI_Comm DistGraph::get() const {
+    return comm_->get();
+}
+
+int DistGraph::rank() const {
+    return comm_->rank();
+}
+
+int DistGraph::size() const {
+    return comm_->size();
+}
+
+const std::vector<int>& DistGraph::sources() const {
+    return sources_;
+}
+
+const std::vector<int>& DistGraph::destinations() const {
+    return destinations_;
+}
+
+int DistGraph::indegree() const {
+    return static_cast<int>(sources_.size());
+}
+
+int DistGraph::outdegree() const {
+    return static_cast<int>(destinations_.size());
+}
+
+}
@@ -1,36 +1,80 @@
 #include <MPIEnvironment.h>
+#include <Trace.h>
 
+#include <cstdlib>
 #include <mpi.h>
+#include <stdexcept>
 
 
 
 namespace mpi {
 
 MPIEnvironment::MPIEnvironment(int &argc, char **&argv) :
-    commSize_([&argc, &argv] {
+    MPIEnvironment([&argc, &argv] {
         if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
            throw std::runtime_error("MPI Initialization failed");
         }
+        int provided;
+        MPI_Query_thread(&provided);
+        return static_cast<Threading>(provided);
+    }()) {}
+
+MPIEnvironment::MPIEnvironment(int &argc, char **&argv, const Threading required, const bool progress) :
+    MPIEnvironment([&argc, &argv, required] {
+        int provided;
+        if (MPI_Init_thread(&argc, &argv, static_cast<int>(required), &provided) != MPI_SUCCESS) {
+           throw std::runtime_error("MPI Initialization failed");
+        }
+        return static_cast<Threading>(provided);
+    }()) {
+    // The environment is constructed at this point, so throwing still finalizes MPI
+    if (static_cast<int>(threading_) < static_cast<int>(required)) {
+        throw std::runtime_error("MPI_Init_thread: requested thread support level not provided");
+    }
+    if (progress) {
+        if (threading_ != Threading::Multiple) {
+            throw std::invalid_argument("MPIEnvironment: a progress thread needs Threading::Multiple");
+        }
+        progress_ = std::make_unique<ProgressThread>(*world_);
+    }
+}
+
+MPIEnvironment::MPIEnvironment(const Threading provided) :
+    threading_(provided),
+    commSize_([] {
         int commSize;
         MPI_Comm_size(MPI_COMM_WORLD, &commSize);
         return commSize;
     }()),
-    local_process_([this] {
-        int rank;
-        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-        return std::make_shared<LocalProcess>(rank, commSize_);
-    }()) {
+    world_(Communicator::world()),
+    local_process_(std::make_shared<LocalProcess>(world_)) {
         for (int i = 0; i < commSize_; ++i) {
         if (i != local_process_->rank()) {
-            remote_processes_->emplace_back(i, commSize_);
+            remote_processes_->emplace_back(world_, i);
         }
     }
+    // Opt-in tracing, MPIWRAPPER_TRACE names the Chrome trace file written at shutdown
+    if (const char* path = std::getenv("MPIWRAPPER_TRACE"); path && *path) {
+        trace::start(world_->get(), path);
+    }
 }
 
 int MPIEnvironment::getCommSize() const {
     return commSize_;
 }
 
+Threading MPIEnvironment::getThreading() const {
+    return threading_;
+}
+
+const ProgressThread* MPIEnvironment::getProgressThread() const {
+    return progress_.get();
+}
+
+std::weak_ptr<Communicator> MPIEnvironment::getWorld() const {
+    return world_;
+}
+
 std::weak_ptr<LocalProcess> MPIEnvironment::getLocalProcess() const {
     return local_process_;
 }
@@ -40,6 +84,8 @@ std::weak_ptr<std::vector<RemoteProcess>> MPIEnvironment::getRemoteProcesses() c
 }
 
 MPIEnvironment::~MPIEnvironment() {
+    progress_.reset();
+    trace::finish(world_->get());
     MPI_Finalize();
 }
 
@@ -4,8 +4,6 @@
 
 namespace mpi {
 
-int Process::ROOT = 0;
-
 int Process::rank() const {
     return rank_;
 }
@@ -14,4 +12,16 @@ int Process::commSize() const {
     return commSize_;
 }
 
+int Process::root() const {
+    return comm_->root();
+}
+
+MPI_Comm Process::comm() const {
+    return comm_->get();
+}
+
+const std::shared_ptr<Communicator>& Process::communicator() const {
+    return comm_;
+}
+
 }
@@ -0,0 +1,34 @@
+#include <ProgressThread.h>
+
+#include <mpi.h>
+
+
+
+namespace mpi {
+
+ProgressThread::ProgressThread(const Communicator& comm, const std::chrono::microseconds interval)
+    : comm_(comm.dup()), interval_(interval), thread_([this] { run(); }) {}
+
+ProgressThread::~ProgressThread() {
+    stop_.store(true, std::memory_order_relaxed);
+    thread_.join();
+}
+
+size_t ProgressThread::polls() const {
+    return polls_.load(std::memory_order_relaxed);
+}
+
+void ProgressThread::run() const {
+    int flag = 0;
+    while (!stop_.load(std::memory_order_relaxed)) {
+        MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, comm_->get(), &flag, MPI_STATUS_IGNORE);
+        polls_.fetch_add(1, std::memory_order_relaxed);
+        if (interval_.count() > 0) {
+            std::this_thread::sleep_for(interval_);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+}
@@ -0,0 +1,197 @@
+#include <Trace.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+namespace mpi::trace {
+
+namespace {
+
+/// Rings of every thread that recorded in the current session
+std::mutex ringsMutex;
+
+std::vector<std::unique_ptr<RingBuffer>> rings;
+
+size_t ringCapacity = 1;
+
+/// Event as sent to rank 0, names copied since pointers differ between processes
+struct Record {
+
+    char name[32];
+
+    char type[32];
+
+    double begin;  // us
+
+    double duration;  // us
+
+    uint64_t bytes;
+
+    int peer;
+
+    uint32_t thread;
+
+};
+
+void copyName(char (&dst)[32], const char* src) {
+    std::strncpy(dst, src, sizeof(dst) - 1);
+    dst[sizeof(dst) - 1] = '\0';
+}
+
+void typeName(char (&dst)[32], MPI_Datatype type) {
+    if (type == MPI_DATATYPE_NULL) {
+        copyName(dst, "");
+        return;
+    }
+    char name[MPI_MAX_OBJECT_NAME];
+    int length = 0;
+    MPI_Type_get_name(type, name, &length);
+    copyName(dst, length > 0 ? name : "derived");
+}
+
+void writeTrace(std::ostream& out, const std::vector<Record>& records, const std::vector<int>& owners,
+                const int commSize) {
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    for (int rank = 0; rank < commSize; ++rank) {
+        out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << rank
+            << ", \"args\": {\"name\": \"rank " << rank << "\"}},\n";
+    }
+    out << std::fixed << std::setprecision(3);
+    for (size_t i = 0; i < records.size(); ++i) {
+        const Record& r = records[i];
+        out << "{\"name\": \"" << r.name << "\", \"cat\": \"mpi\", \"ph\": \"X\", \"ts\": " << r.begin
+            << ", \"dur\": " << r.duration << ", \"pid\": " << owners[i] << ", \"tid\": " << r.thread
+            << ", \"args\": {\"bytes\": " << r.bytes << ", \"peer\": " << r.peer
+            << ", \"type\": \"" << r.type << "\"}}" << (i + 1 < records.size() ? "," : "") << "\n";
+    }
+    out << "]}\n";
+}
+
+void writeSummary(std::ostream& out, const std::vector<Record>& records, const uint64_t dropped) {
+    struct Totals {
+        uint64_t calls = 0;
+        double total = 0;
+        double max = 0;
+        uint64_t bytes = 0;
+    };
+    std::map<std::string, Totals> ops;
+    for (const Record& r : records) {
+        Totals& totals = ops[r.name];
+        ++totals.calls;
+        totals.total += r.duration;
+        totals.max = std::max(totals.max, r.duration);
+        totals.bytes += r.bytes;
+    }
+    std::vector<std::pair<std::string, Totals>> sorted(ops.begin(), ops.end());
+    std::ranges::sort(sorted, [](const auto& a, const auto& b) { return a.second.total > b.second.total; });
+
+    out << std::left << std::setw(24) << "operation" << std::right << std::setw(12) << "calls"
+        << std::setw(16) << "total [us]" << std::setw(14) << "mean [us]" << std::setw(14) << "max [us]"
+        << std::setw(18) << "bytes" << "\n";
+    out << std::fixed << std::setprecision(2);
+    for (const auto& [name, totals] : sorted) {
+        out << std::left << std::setw(24) << name << std::right << std::setw(12) << totals.calls
+            << std::setw(16) << totals.total << std::setw(14) << totals.total / static_cast<double>(totals.calls)
+            << std::setw(14) << totals.max << std::setw(18) << totals.bytes << "\n";
+    }
+    if (dropped > 0) {
+        out << dropped << " events overwritten, raise the ring capacity to keep them\n";
+    }
+}
+
+}
+
+RingBuffer* registerThread() {
+    const std::lock_guard lock(ringsMutex);
+    rings.push_back(std::make_unique<RingBuffer>(ringCapacity));
+    return rings.back().get();
+}
+
+void start(MPI_Comm comm, const std::string& path, const size_t capacity) {
+    {
+        const std::lock_guard lock(ringsMutex);
+        rings.clear();
+        ringCapacity = std::max<size_t>(capacity, 1);
+    }
+    session.fetch_add(1, std::memory_order_acq_rel);
+    output = path;
+    MPI_Barrier(comm);
+    epoch = std::chrono::steady_clock::now();
+    active.store(true, std::memory_order_release);
+}
+
+void finish(MPI_Comm comm) {
+    if (!active.exchange(false, std::memory_order_seq_cst)) {
+        return;
+    }
+    // Spans of other threads that got past their check finish their push before the rings are read
+    while (recording.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+
+    int rank;
+    int commSize;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &commSize);
+
+    std::vector<Record> local;
+    uint64_t dropped = 0;
+    {
+        const std::lock_guard lock(ringsMutex);
+        for (const auto& ring : rings) {
+            for (size_t i = 0; i < ring->size(); ++i) {
+                const Event& event = (*ring)[i];
+                Record& record = local.emplace_back();
+                copyName(record.name, event.name);
+                typeName(record.type, event.type);
+                record.begin = static_cast<double>(event.begin) * 1e-3;
+                record.duration = static_cast<double>(event.end - event.begin) * 1e-3;
+                record.bytes = event.bytes;
+                record.peer = event.peer;
+                record.thread = event.thread;
+            }
+            dropped += ring->pushed() - ring->size();
+        }
+        rings.clear();
+    }
+
+    const int count = static_cast<int>(local.size());
+    std::vector<int> counts(rank == 0 ? static_cast<size_t>(commSize) : 0);
+    MPI_Gather(&count, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, comm);
+    MPI_Reduce(rank == 0 ? MPI_IN_PLACE : &dropped, &dropped, 1, MPI_UINT64_T, MPI_SUM, 0, comm);
+
+    MPI_Datatype recordType;
+    MPI_Type_contiguous(static_cast<int>(sizeof(Record)), MPI_BYTE, &recordType);
+    MPI_Type_commit(&recordType);
+    std::vector<int> displs(counts.size());
+    std::vector<Record> records;
+    std::vector<int> owners;
+    if (rank == 0) {
+        int offset = 0;
+        for (size_t r = 0; r < counts.size(); ++r) {
+            displs[r] = offset;
+            offset += counts[r];
+            owners.insert(owners.end(), static_cast<size_t>(counts[r]), static_cast<int>(r));
+        }
+        records.resize(static_cast<size_t>(offset));
+    }
+    MPI_Gatherv(local.data(), count, recordType, records.data(), counts.data(), displs.data(), recordType, 0, comm);
+    MPI_Type_free(&recordType);
+
+    if (rank == 0) {
+        std::ofstream trace(output);
+        writeTrace(trace, records, owners, commSize);
+        std::ofstream summary(output + ".summary.txt");
+        writeSummary(summary, records, dropped);
+    }
+}
+
+}
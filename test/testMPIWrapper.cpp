@@ -1,10 +1,30 @@
 #define DOCTEST_CONFIG_IMPLEMENT
 #include <doctest/doctest.h>
 #include <MPIEnvironment.h>
+#include <Aggregator.h>
+#include <Cartesian.h>
+#include <Coroutine.h>
+#include <DistGraph.h>
+#include <DistributedArray.h>
+#include <HaloExchange.h>
 #include <Operations.h>
-
+#include <RequestSet.h>
+#include <Sort.h>
+#include <SendQueue.h>
+#include <shared_array.h>
+#include <Trace.h>
+#include <Window.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <cstdint>
 #include <thread>
 #include <iostream>
+#include <span>
 #include <vector>
 #include <cmath>
 
@@ -12,6 +32,17 @@
 
 std::unique_ptr<mpi::MPIEnvironment> mpi_env;
 
+struct Particle {
+    double pos[3];
+    char tag;
+    int id;
+};
+
+template<>
+struct mpi_fields<Particle> {
+    static constexpr auto value = std::make_tuple(&Particle::pos, &Particle::tag, &Particle::id);
+};
+
 bool areEqual(const double a, const double b, const double e = 0.0001) {
     return std::abs(a - b) < e;
 }
@@ -22,11 +53,11 @@ TEST_CASE("Root/Worker Execute") {
 
     if (auto l = local.lock()) {
         (*l)([l] {
-            CHECK(l->rank() == mpi::Process::ROOT);
+            CHECK(l->rank() == l->root());
             std::cout << "Running from root process"  << std::endl;
         });
         (~*l)([l] {
-            CHECK(l->rank() != mpi::Process::ROOT);
+            CHECK(l->rank() != l->root());
             std::cout << "Running from worker process"  << std::endl;
         });
         for (int i = 0; i < l->commSize(); i++) {
@@ -200,6 +231,1358 @@ TEST_CASE("Broadcast&Gather") {
     }
 }
 
+TEST_CASE("IScatter&IGather") {
+    const auto local = mpi_env->getLocalProcess().lock();
+
+    CHECK(local);
+
+    const size_t DATASIZE = 8 * static_cast<size_t>(mpi_env->getCommSize());
+
+    auto scattered = mpi::iscatter(
+    local->init<int>(
+        [](const mpi::array<int>& data) {
+            for (int i = 0; auto& val : data) {
+                val = i++;
+            }
+        }, DATASIZE)
+    );
+
+    mpi::array chunk = scattered();
+
+    CHECK(chunk.size() == DATASIZE / static_cast<size_t>(mpi_env->getCommSize()));
+
+    for (auto& val : chunk) {
+        val = val * val;
+    }
+
+    auto gathered = mpi::igather(local->forward(std::move(chunk)));
+
+    const mpi::array result = gathered();
+
+    if (!result.empty()) {
+        CHECK(result.size() == DATASIZE);
+        for (int i = 0; const auto& val : result) {
+            CHECK(val == i * i);
+            i++;
+        }
+        CHECK(local->rank() == 0);
+    } else {
+        CHECK(local->rank() != 0);
+    }
+}
+
+TEST_CASE("IAllReduce&IReduceScatter") {
+    const auto local = mpi_env->getLocalProcess().lock();
+
+    CHECK(local);
+
+    const auto commSize = mpi_env->getCommSize();
+
+    constexpr size_t DATASIZE = 9;
+
+    mpi::array<int> data(DATASIZE);
+    for (int i = 0; auto& val : data) {
+        val = i++ + local->rank();
+    }
+
+    auto reduced = mpi::iallReduce<int>(*local + mpi::array(data));
+    auto scattered = mpi::ireduceScatter<int>(*local + std::move(data));
+
+    // Overlapping computation would go here
+    const mpi::array sum = reduced();
+    const mpi::array part = scattered();
+
+    CHECK(sum.size() == DATASIZE);
+    for (int i = 0; const auto& val : sum) {
+        CHECK(val == i * commSize + commSize * (commSize - 1) / 2);
+        i++;
+    }
+
+    const auto size = static_cast<size_t>(commSize);
+    const auto rank = static_cast<size_t>(local->rank());
+    CHECK(part.size() == DATASIZE / size + (rank < DATASIZE % size ? 1 : 0));
+    size_t offset = 0;
+    for (size_t r = 0; r < rank; ++r) {
+        offset += DATASIZE / size + (r < DATASIZE % size ? 1 : 0);
+    }
+    for (size_t i = 0; i < part.size(); ++i) {
+        CHECK(part[i] == sum[offset + i]);
+    }
+}
+
+TEST_CASE("PersistentPlans") {
+    const auto local = mpi_env->getLocalProcess().lock();
+    const auto remote = mpi_env->getRemoteProcesses().lock();
+
+    CHECK(local);
+    CHECK(remote);
+
+    const int commSize = mpi_env->getCommSize();
+
+    constexpr size_t DATASIZE = 8;
+    constexpr int ITERATIONS = 5;
+
+    auto sum = mpi::allReducePlan<int>(*local + mpi::array<int>(DATASIZE));
+
+    for (int it = 0; it < ITERATIONS; ++it) {
+        for (auto& val : sum.src()) {
+            val = it + local->rank();
+        }
+        sum.start();
+        sum.wait();
+        for (const auto& val : sum.result()) {
+            CHECK(val == it * commSize + commSize * (commSize - 1) / 2);
+        }
+    }
+
+    // Assigning over an active plan completes it before its buffers go
+    sum.start();
+    sum = mpi::allReducePlan<int>(*local + mpi::array<int>(DATASIZE));
+    std::fill(sum.src().begin(), sum.src().end(), 1);
+    sum();
+    CHECK(sum.result()[0] == commSize);
+
+    if (commSize < 2) {
+        return;
+    }
+
+    const int next = (local->rank() + 1) % commSize;
+    const int prev = (local->rank() + commSize - 1) % commSize;
+    const auto to = std::ranges::find_if(*remote, [next](const mpi::RemoteProcess& r) { return r.rank() == next; });
+    const auto from = std::ranges::find_if(*remote, [prev](const mpi::RemoteProcess& r) { return r.rank() == prev; });
+
+    auto send = to->persistent() << mpi::array<int>(DATASIZE);
+    auto recv = from->persistent() >> mpi::array<int>(DATASIZE);
+
+    for (int it = 0; it < ITERATIONS; ++it) {
+        for (auto& val : send.src()) {
+            val = it * commSize + local->rank();
+        }
+        recv.start();
+        send.start();
+        send.wait();
+        recv.wait();
+        for (const auto& val : recv.result()) {
+            CHECK(val == it * commSize + prev);
+        }
+    }
+}
+
+TEST_CASE("DerivedDatatype") {
+    const auto local = mpi_env->getLocalProcess().lock();
+
+    CHECK(local);
+
+    static_assert(is_mpi_type<Particle>::value);
+
+    int size;
+    MPI_Type_size(get_mpi_type<Particle>(), &size);
+    CHECK(static_cast<size_t>(size) == 3 * sizeof(double) + sizeof(char) + sizeof(int));
+    CHECK(get_mpi_type<Particle>() == get_mpi_type<Particle>());
+
+    const size_t DATASIZE = 4 * static_cast<size_t>(mpi_env->getCommSize());
+
+    mpi::array chunk = mpi::scatter(
+    local->init<Particle>(
+        [](const mpi::array<Particle>& data) {
+            for (int i = 0; auto& p : data) {
+                p = {{i * 1.0, i * 2.0, i * 3.0}, static_cast<char>('a' + i % 26), i};
+                i++;
+            }
+        }, DATASIZE)
+    );
+
+    for (auto& p : chunk) {
+        p.pos[0] += 1.0;
+    }
+
+    const mpi::array result = mpi::allGather<Particle>(local->forward(std::move(chunk)));
+
+    CHECK(result.size() == DATASIZE);
+    for (int i = 0; const auto& p : result) {
+        CHECK(p.id == i);
+        CHECK(p.tag == static_cast<char>('a' + i % 26));
+        CHECK(areEqual(p.pos[0], i + 1.0));
+        CHECK(areEqual(p.pos[2], i * 3.0));
+        i++;
+    }
+}
+
+TEST_CASE("CustomReduction") {
+    const auto local = mpi_env->getLocalProcess().lock();
+
+    CHECK(local);
+
+    const int commSize = mpi_env->getCommSize();
+
+    constexpr size_t DATASIZE = 8;
+
+    mpi::array<double> values(DATASIZE);
+    for (int i = 0; auto& val : values) {
+        val = (local->rank() % 2 ? -1.0 : 1.0) * (local->rank() + i++);
+    }
+
+    const auto absMax = [](const double a, const double b) { return std::abs(a) > std::abs(b) ? a : b; };
+    const mpi::array maxAbs = mpi::allReduce<double>(local->custom(absMax, std::move(values)));
+
+    CHECK(maxAbs.size() == DATASIZE);
+    for (int i = 0; const auto& val : maxAbs) {
+        const int r = commSize - 1;
+        CHECK(areEqual(val, (r % 2 ? -1.0 : 1.0) * (r + i++)));
+    }
+
+    mpi::array<Particle> particles(DATASIZE);
+    for (int i = 0; auto& p : particles) {
+        p = {{static_cast<double>((local->rank() + i) % commSize), 0.0, 0.0}, 'p', local->rank()};
+        i++;
+    }
+
+    const auto minWithIndex = [](const Particle& a, const Particle& b) {
+        return a.pos[0] < b.pos[0] || (a.pos[0] == b.pos[0] && a.id < b.id) ? a : b;
+    };
+    const mpi::array nearest = mpi::allReduce<Particle>(local->custom(minWithIndex, std::move(particles)));
+
+    for (int i = 0; const auto& p : nearest) {
+        CHECK(areEqual(p.pos[0], 0.0));
+        CHECK(p.id == (commSize - i % commSize) % commSize);
+        i++;
+    }
+
+    mpi::array<int> ones(DATASIZE);
+    for (auto& val : ones) {
+        val = 1;
+    }
+    const mpi::array prefix = mpi::scan<int>(local->custom([](const int a, const int b) { return a + b; },
+        std::move(ones)));
+    for (const auto& val : prefix) {
+        CHECK(val == local->rank() + 1);
+    }
+}
+
+TEST_CASE("Scatterv&Gatherv") {
+    const auto local = mpi_env->getLocalProcess().lock();
+
+    CHECK(local);
+
+    const auto commSize = static_cast<size_t>(mpi_env->getCommSize());
+    const auto rank = static_cast<size_t>(local->rank());
+
+    constexpr size_t DATASIZE = 13;
+
+    mpi::array chunk = mpi::scatterv(
+    local->initv<int>(
+        [](const mpi::array<int>& data) {
+            CHECK(data.size() == DATASIZE);
+            for (int i = 0; auto& val : data) {
+                val = i++;
+            }
+        }, DATASIZE)
+    );
+
+    CHECK(chunk.size() == DATASIZE / commSize + (rank < DATASIZE % commSize ? 1 : 0));
+
+    for (auto& val : chunk) {
+        val = val * val;
+    }
+
+    const mpi::array everything = mpi::allGatherv<int>(local->forward(mpi::array(chunk)));
+    CHECK(everything.size() == DATASIZE);
+
+    const mpi::array result = mpi::gatherv<int>(local->forward(std::move(chunk)));
+
+    if (!result.empty()) {
+        CHECK(result.size() == DATASIZE);
+        for (int i = 0; const auto& val : result) {
+            CHECK(val == i * i);
+            CHECK(everything[static_cast<size_t>(i)] == i * i);
+            i++;
+        }
+    }
+
+    mpi::array<int> partition(commSize);
+    partition[commSize - 1] = static_cast<int>(DATASIZE);
+    const mpi::array last = mpi::scatterv(local->initv<int>([](const mpi::array<int>&) {}, DATASIZE), partition);
+    CHECK(last.size() == (rank == commSize - 1 ? DATASIZE : 0));
+}
+
+TEST_CASE("AllToAllv") {
+    const auto local = mpi_env->getLocalProcess().lock();
+
+    CHECK(local);
+
+    const auto commSize = static_cast<size_t>(mpi_env->getCommSize());
+    const auto rank = static_cast<size_t>(local->rank());
+
+    // Rank r sends r + 1 copies of its rank to every peer
+    mpi::array<int> data((rank + 1) * commSize);
+    for (auto& val : data) {
+        val = static_cast<int>(rank);
+    }
+
+    const mpi::array received = mpi::allToAllv<int>(local->forward(std::move(data)));
+
+    CHECK(received.size() == commSize * (commSize + 1) / 2);
+    for (size_t i = 0, source = 0; source < commSize; ++source) {
+        for (size_t k = 0; k <= source; ++k, ++i) {
+            CHECK(received[i] == static_cast<int>(source));
+        }
+    }
+}
+
+/// Throws from the constructor of its third instance
+struct Fragile {
+    Fragile() {
+        if (++constructed == 3) {
+            throw std::runtime_error("Fragile");
+        }
+    }
+
+    static inline int constructed = 0;
+};
+
+TEST_CASE("ArrayAllocators") {
+    const auto local = mpi_env->getLocalProcess().lock();
+
+    CHECK(local);
+
+    const size_t DATASIZE = 8 * static_cast<size_t>(mpi_env->getCommSize());
+
+    using Registered = mpi::mpi_allocator<int>;
+    using Aligned = mpi::aligned_allocator<double>;
+    using Raw = mpi::uninitialized_allocator<double>;
+
+    const mpi::array<double, Aligned> aligned(DATASIZE);
+    CHECK(reinterpret_cast<std::uintptr_t>(aligned.data()) % 64 == 0);
+    CHECK(aligned[0] == 0.0);
+
+    const mpi::array<double, Raw> raw(DATASIZE);
+    CHECK(reinterpret_cast<std::uintptr_t>(raw.data()) % 64 == 0);
+
+    mpi::array chunk = mpi::scatter(
+    local->init<int, Registered>(
+        [](const mpi::array<int, Registered>& data) {
+            for (int i = 0; auto& val : data) {
+                val = i++;
+            }
+        }, DATASIZE)
+    );
+
+    static_assert(std::is_same_v<decltype(chunk), mpi::array<int, Registered>>);
+
+    for (auto& val : chunk) {
+        val = val * val;
+    }
+
+    const mpi::array result = mpi::allGather(local->forward(std::move(chunk)));
+
+    static_assert(std::is_same_v<decltype(result), const mpi::array<int, Registered>>);
+
+    CHECK(result.size() == DATASIZE);
+    for (int i = 0; const auto& val : result) {
+        CHECK(val == i * i);
+        i++;
+    }
+
+    // A throwing element constructor must not leak the aligned block
+    CHECK_THROWS_AS((mpi::array<Fragile, mpi::aligned_allocator<Fragile>>(4)), std::runtime_error);
+    CHECK(Fragile::constructed == 3);
+}
+
+TEST_CASE("ArrayViews") {
+    const auto local = mpi_env->getLocalProcess().lock();
+    const auto remote = mpi_env->getRemoteProcesses().lock();
+
+    CHECK(local);
+    CHECK(remote);
+
+    const int commSize = mpi_env->getCommSize();
+
+    constexpr size_t DATASIZE = 32;
+
+    std::vector<int> values(DATASIZE);
+    for (int i = 0; auto& val : values) {
+        val = i++;
+    }
+
+    mpi::array_view view(values);
+    CHECK(!view.owner());
+    CHECK(view.data() == values.data());
+    CHECK(view.size() == DATASIZE);
+
+    mpi::array chunk = mpi::scatter(local->bind(mpi::array_view(values), DATASIZE));
+    CHECK(chunk.owner());
+    CHECK(chunk.size() == DATASIZE / static_cast<size_t>(commSize));
+    CHECK(chunk[0] == local->rank() * static_cast<int>(chunk.size()));
+
+    const mpi::array sum = mpi::allReduce<int>(*local + mpi::array_view(std::span(values).subspan(4, 8)));
+    CHECK(sum.size() == 8);
+    for (int i = 0; const auto& val : sum) {
+        CHECK(val == (i++ + 4) * commSize);
+    }
+
+    if (commSize < 2) {
+        return;
+    }
+
+    const int next = (local->rank() + 1) % commSize;
+    const int prev = (local->rank() + commSize - 1) % commSize;
+    const auto to = std::ranges::find_if(*remote, [next](const mpi::RemoteProcess& r) { return r.rank() == next; });
+    const auto from = std::ranges::find_if(*remote, [prev](const mpi::RemoteProcess& r) { return r.rank() == prev; });
+
+    std::vector<int> received(DATASIZE);
+    auto await = from->async() >> mpi::array_view(received, 0, 16);
+    to->sync() << mpi::array_view(values, 16, 16);
+    await();
+
+    for (int i = 0; i < 16; ++i) {
+        CHECK(received[static_cast<size_t>(i)] == i + 16);
+    }
+    CHECK(received[16] == 0);
+}
+
+TEST_CASE("InPlaceCollectives") {
+    const auto local = mpi_env->getLocalProcess().lock();
+
+    CHECK(local);
+
+    const int commSize = mpi_env->getCommSize();
+    const int rank = local->rank();
+
+    constexpr size_t DATASIZE = 8;
+
+    std::vector<int> gradient(DATASIZE, rank + 1);
+
+    const mpi::array summed = mpi::allReduceInPlace<int>(*local + mpi::array_view(gradient));
+    CHECK(summed.data() == gradient.data());
+    for (const auto& val : gradient) {
+        CHECK(val == commSize * (commSize + 1) / 2);
+    }
+
+    std::ranges::fill(gradient, rank + 1);
+    const mpi::array reduced = mpi::reduceInPlace<int>(local->max(mpi::array_view(gradient)));
+    CHECK(reduced.data() == gradient.data());
+    if (rank == local->root()) {
+        CHECK(gradient[0] == commSize);
+    }
+
+    std::ranges::fill(gradient, 1);
+    const mpi::array_view ones(gradient);
+    const mpi::array prefix = mpi::scanInPlace<int>(*local + mpi::array<int>(ones));
+    CHECK(prefix.owner());
+    for (const auto& val : prefix) {
+        CHECK(val == rank + 1);
+    }
+
+    const auto blocks = static_cast<size_t>(commSize);
+    std::vector<int> all(DATASIZE * blocks, -1);
+    for (size_t i = 0; i < DATASIZE; ++i) {
+        all[static_cast<size_t>(rank) * DATASIZE + i] = rank;
+    }
+    const mpi::array gathered = mpi::allGatherInPlace<int>(local->forward(mpi::array_view(all)));
+    CHECK(gathered.size() == all.size());
+    for (size_t i = 0; i < all.size(); ++i) {
+        CHECK(all[i] == static_cast<int>(i / DATASIZE));
+    }
+
+    std::ranges::fill(all, -1);
+    for (size_t i = 0; i < DATASIZE; ++i) {
+        all[static_cast<size_t>(rank) * DATASIZE + i] = rank * 10;
+    }
+    const bool isRoot = rank == local->root();
+    const mpi::array mine = mpi::gatherInPlace<int>(local->forward(isRoot
+        ? mpi::array_view(all)
+        : mpi::array_view(all, static_cast<size_t>(rank) * DATASIZE, DATASIZE)));
+    if (isRoot) {
+        for (size_t i = 0; i < all.size(); ++i) {
+            CHECK(all[i] == static_cast<int>(i / DATASIZE) * 10);
+        }
+    } else {
+        CHECK(mine.size() == DATASIZE);
+    }
+}
+
+TEST_CASE("CommunicatorSplit") {
+    const auto local = mpi_env->getLocalProcess().lock();
+    const auto world = mpi_env->getWorld().lock();
+
+    CHECK(local);
+    CHECK(world);
+    CHECK(world->get() == MPI_COMM_WORLD);
+
+    const int rank = local->rank();
+    const int commSize = mpi_env->getCommSize();
+
+    const auto parity = world->split(rank % 2, rank);
+    CHECK(parity);
+
+    const mpi::LocalProcess row(parity);
+    CHECK(row.rank() == rank / 2);
+    CHECK(row.commSize() == (commSize + 1 - rank % 2) / 2);
+
+    const mpi::array sum = mpi::allReduce<int>(row + mpi::array<int>({rank}));
+    int expected = 0;
+    for (int r = rank % 2; r < commSize; r += 2) {
+        expected += r;
+    }
+    CHECK(sum[0] == expected);
+
+    row(row.commSize() - 1);
+    CHECK(row.root() == row.commSize() - 1);
+    CHECK(local->root() == 0);
+
+    const mpi::array gathered = mpi::gather<int>(row.forward(mpi::array<int>({rank})));
+    if (row.rank() == row.root()) {
+        CHECK(gathered.size() == static_cast<size_t>(row.commSize()));
+        CHECK(gathered[0] == rank % 2);
+    } else {
+        CHECK(gathered.empty());
+    }
+
+    const auto copy = parity->dup();
+    CHECK(copy->get() != parity->get());
+    CHECK(copy->root() == parity->root());
+    CHECK(copy->size() == parity->size());
+
+    const auto none = world->split(MPI_UNDEFINED);
+    CHECK(!none);
+}
+
+TEST_CASE("SharedArray") {
+    const auto local = mpi_env->getLocalProcess().lock();
+    const auto world = mpi_env->getWorld().lock();
+
+    CHECK(local);
+    CHECK(world);
+
+    constexpr size_t DATASIZE = 64;
+
+    const auto node = world->splitShared();
+    mpi::shared_array<double> table(node, DATASIZE);
+
+    CHECK(table.size() == DATASIZE);
+    CHECK(table[0] == 0.0);
+
+    table.fence();
+    if (node->rank() == 0) {
+        for (int i = 0; auto& val : table) {
+            val = std::sqrt(static_cast<double>(i++));
+        }
+    }
+    table.fence();
+
+    for (size_t i = 0; i < DATASIZE; ++i) {
+        CHECK(areEqual(table[i], std::sqrt(static_cast<double>(i))));
+    }
+
+    const mpi::LocalProcess nodeLocal(node);
+    const mpi::array sum = mpi::allReduce<double>(nodeLocal + mpi::array<double>(table.view()));
+    CHECK(areEqual(sum[4], 2.0 * node->size()));
+}
+
+TEST_CASE("RMAWindow") {
+    const auto local = mpi_env->getLocalProcess().lock();
+    const auto world = mpi_env->getWorld().lock();
+
+    CHECK(local);
+    CHECK(world);
+
+    const int rank = local->rank();
+    const int commSize = mpi_env->getCommSize();
+    const auto size = static_cast<size_t>(commSize);
+
+    mpi::Window<int> window(world, size + 2);
+    CHECK(window.size() == size + 2);
+    CHECK(window[0] == 0);
+
+    // Active target: everyone writes its rank into slot rank of its right neighbour
+    window.fence();
+    const int next = (rank + 1) % commSize;
+    window.put(mpi::array<int>({rank}), next, static_cast<size_t>(rank));
+    window.accumulate(mpi::array<int>({1}), 0, size);
+    window.fence();
+
+    const int prev = (rank + commSize - 1) % commSize;
+    CHECK(window[static_cast<size_t>(prev)] == prev);
+    if (rank == 0) {
+        CHECK(window[size] == commSize);
+    }
+
+    // Passive target: a distributed counter on rank 0
+    window.lockAll();
+    const int ticket = window.fetchAndOp(1, 0, size + 1);
+    CHECK(ticket >= 0);
+    CHECK(ticket < commSize);
+
+    const int beforePrev = (prev + commSize - 1) % commSize;
+    const mpi::array<int> remote(1);
+    auto await = window.rget(remote, prev, static_cast<size_t>(beforePrev));
+    await();
+    window.unlockAll();
+    CHECK(remote[0] == beforePrev);
+
+    // Exactly one rank wins the swap once every rank took its ticket
+    MPI_Barrier(MPI_COMM_WORLD);
+    window.lockAll();
+    const int seen = window.compareAndSwap(-1, commSize, 0, size + 1);
+    window.unlockAll();
+    CHECK((seen == commSize || seen == -1));
+    const mpi::array winners = mpi::allReduce<int>(*local + mpi::array<int>({seen == commSize ? 1 : 0}));
+    CHECK(winners[0] == 1);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank == 0) {
+        window.sync();
+        CHECK(window[size + 1] == -1);
+    }
+}
+
+TEST_CASE("MatchedProbeReceive") {
+    const auto local = mpi_env->getLocalProcess().lock();
+    const auto remote = mpi_env->getRemoteProcesses().lock();
+
+    CHECK(local);
+    CHECK(remote);
+
+    const int rank = local->rank();
+    const int commSize = mpi_env->getCommSize();
+
+    if (commSize < 2) {
+        return;
+    }
+
+    constexpr int TAG = 7;
+
+    // Every worker sends rank + 1 values to root, root drains them in arrival order
+    if (rank != local->root()) {
+        const auto root = std::ranges::find_if(*remote, [&local](const mpi::RemoteProcess& r) {
+            return r.rank() == local->root();
+        });
+        mpi::array<int> data(static_cast<size_t>(rank + 1));
+        for (auto& val : data) {
+            val = rank;
+        }
+        root->sync(TAG) << data;
+        root->sync(TAG + 1) << mpi::array<double>({0.5 * rank});
+
+        const mpi::array echo = root->sync(TAG).receive<int>();
+        CHECK(echo.size() == static_cast<size_t>(rank));
+    } else {
+        std::vector<bool> seen(static_cast<size_t>(commSize), false);
+        for (int i = 1; i < commSize; ++i) {
+            const auto message = local->receive<int>(TAG);
+            CHECK(message.tag == TAG);
+            CHECK(message.data.size() == static_cast<size_t>(message.source + 1));
+            CHECK(message.data[0] == message.source);
+            CHECK(!seen[static_cast<size_t>(message.source)]);
+            seen[static_cast<size_t>(message.source)] = true;
+        }
+        for (int i = 1; i < commSize; ++i) {
+            std::optional<mpi::Message<double>> message;
+            while (!(message = local->tryReceive<double>(TAG + 1))) {}
+            CHECK(areEqual(message->data[0], 0.5 * message->source));
+        }
+        CHECK(!local->tryReceive<int>());
+        for (auto& r : *remote) {
+            r.sync(TAG) << mpi::array<int>(static_cast<size_t>(r.rank()));
+        }
+    }
+}
+
+TEST_CASE("RequestSet") {
+    const auto local = mpi_env->getLocalProcess().lock();
+    const auto remote = mpi_env->getRemoteProcesses().lock();
+
+    CHECK(local);
+    CHECK(remote);
+
+    const int rank = local->rank();
+    const size_t neighbours = remote->size();
+
+    constexpr size_t N = 4;
+    constexpr int TAG = 11;
+
+    // Exchange with every other rank, each receive checked by its callback as it completes
+    mpi::array<int> sent(N);
+    for (size_t i = 0; i < N; ++i) {
+        sent[i] = rank * 10 + static_cast<int>(i);
+    }
+    std::vector<mpi::array<int>> received(neighbours, mpi::array<int>(N));
+    size_t checked = 0;
+
+    mpi::RequestSet receives;
+    mpi::RequestSet sends;
+    receives.reserve(neighbours);
+    sends.reserve(neighbours);
+    for (size_t i = 0; i < neighbours; ++i) {
+        auto& r = (*remote)[i];
+        receives.add(r.async(TAG) >> received[i], [&received, &checked, i, &r] {
+            CHECK(received[i][N - 1] == r.rank() * 10 + static_cast<int>(N - 1));
+            ++checked;
+        });
+        sends += r.async(TAG) << sent;
+    }
+    CHECK(receives.size() == neighbours);
+
+    // Drain the first completion blocking, the rest by polling
+    if (neighbours > 0) {
+        const auto first = receives.waitAny();
+        CHECK(first);
+        CHECK(checked == 1);
+    }
+    while (!receives.test()) {}
+    CHECK(receives.pending() == 0);
+    CHECK(checked == neighbours);
+    CHECK(!receives.waitAny());
+
+    sends.waitAll();
+    CHECK(sends.empty());
+
+    // Storage is kept across rounds
+    sends.clear();
+    CHECK(sends.size() == 0);
+    for (auto& r : *remote) {
+        sends.add(r.async(TAG + 1) << sent);
+    }
+    for (size_t i = 0; i < neighbours; ++i) {
+        receives.add((*remote)[i].async(TAG + 1) >> received[i]);
+    }
+    receives.waitAll();
+    for (size_t i = 0; i < neighbours; ++i) {
+        CHECK(received[i][0] == (*remote)[i].rank() * 10);
+    }
+
+    // Moving hands the pending requests over, assigning over them waits first
+    mpi::RequestSet moved(std::move(sends));
+    CHECK(sends.empty());
+    CHECK(sends.pending() == 0);
+    CHECK(moved.pending() <= neighbours);
+    moved = mpi::RequestSet();
+    CHECK(moved.empty());
+}
+
+namespace {
+
+// Sends rounds values to one neighbour and sums what comes back, suspending on every transfer
+mpi::Task exchange(mpi::RemoteProcess& r, const int rank, const int rounds, int& sum) {
+    for (int i = 0; i < rounds; ++i) {
+        const mpi::array<int> out({rank + i});
+        const mpi::array<int> in(1);
+        auto received = r.async(i) >> in;
+        co_await (r.async(i) << out);
+        co_await std::move(received);
+        sum += in[0];
+    }
+}
+
+mpi::Task reduceAll(const mpi::LocalProcess& local, int& total) {
+    auto future = mpi::iallReduce<int>(local + mpi::array<int>({local.rank()}));
+    const mpi::array reduced = co_await future;
+    total = reduced[0];
+}
+
+mpi::Task pipeline(const mpi::LocalProcess& local, int& total, int& steps) {
+    co_await reduceAll(local, total);
+    ++steps;
+    co_await reduceAll(local, total);
+    ++steps;
+}
+
+mpi::Task failing() {
+    throw std::runtime_error("failing task");
+    co_return;
+}
+
+}
+
+TEST_CASE("Coroutines") {
+    const auto local = mpi_env->getLocalProcess().lock();
+    const auto remote = mpi_env->getRemoteProcesses().lock();
+
+    CHECK(local);
+    CHECK(remote);
+
+    const int rank = local->rank();
+    const int commSize = mpi_env->getCommSize();
+    constexpr int ROUNDS = 3;
+
+    // Collectives are issued first so every rank posts them in the same order
+    int total = -1;
+    int steps = 0;
+    std::vector<int> sums(remote->size(), 0);
+    mpi::Scheduler scheduler;
+    scheduler.spawn(pipeline(*local, total, steps));
+    for (size_t i = 0; i < remote->size(); ++i) {
+        scheduler.spawn(exchange((*remote)[i], rank, ROUNDS, sums[i]));
+    }
+    CHECK(scheduler.size() == remote->size() + 1);
+    scheduler.run();
+
+    CHECK(scheduler.size() == 0);
+    CHECK(scheduler.pending() == 0);
+    CHECK(steps == 2);
+    CHECK(total == commSize * (commSize - 1) / 2);
+    for (size_t i = 0; i < remote->size(); ++i) {
+        CHECK(sums[i] == ROUNDS * (*remote)[i].rank() + ROUNDS * (ROUNDS - 1) / 2);
+    }
+
+    mpi::Scheduler throwing;
+    throwing.spawn(failing());
+    CHECK_THROWS_AS(throwing.run(), std::runtime_error);
+}
+
+TEST_CASE("ProgressThread") {
+    const auto local = mpi_env->getLocalProcess().lock();
+    const auto remote = mpi_env->getRemoteProcesses().lock();
+
+    CHECK(local);
+    CHECK(remote);
+
+    // The environment is initialised without threads, polling from a second thread needs MULTIPLE
+    int provided;
+    MPI_Query_thread(&provided);
+    if (provided < MPI_THREAD_MULTIPLE) {
+        return;
+    }
+    const auto progress = std::make_unique<mpi::ProgressThread>(*mpi_env->getWorld().lock());
+
+    // Large messages are in flight while the rank computes, the progress thread moves them along
+    constexpr size_t N = 1 << 20;
+    constexpr int TAG = 13;
+    const int rank = local->rank();
+    mpi::array<double> out(N);
+    std::fill(out.begin(), out.end(), static_cast<double>(rank));
+    std::vector<mpi::array<double>> in(remote->size(), mpi::array<double>(N));
+
+    mpi::RequestSet requests;
+    for (size_t i = 0; i < remote->size(); ++i) {
+        requests.add((*remote)[i].async(TAG) >> in[i]);
+        requests.add((*remote)[i].async(TAG) << out);
+    }
+
+    const size_t before = progress->polls();
+    double acc = 0;
+    for (size_t i = 0; i < N; ++i) {
+        acc += std::sqrt(static_cast<double>(i));
+    }
+    CHECK(acc > 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    requests.waitAll();
+
+    CHECK(progress->polls() > before);
+    for (size_t i = 0; i < remote->size(); ++i) {
+        CHECK(in[i][N - 1] == static_cast<double>((*remote)[i].rank()));
+    }
+}
+
+TEST_CASE("SendQueue") {
+    const auto local = mpi_env->getLocalProcess().lock();
+    const auto remote = mpi_env->getRemoteProcesses().lock();
+
+    CHECK(local);
+    CHECK(remote);
+
+    constexpr int WORKERS = 4;
+    constexpr int MESSAGES = 8;
+    constexpr int TAG = 100;
+    const int rank = local->rank();
+
+    // One receive per (sender, worker, message), the tag tells them apart
+    std::vector<mpi::array<int>> in;
+    in.reserve(remote->size() * WORKERS * MESSAGES);
+    mpi::RequestSet receives;
+    for (auto& r : *remote) {
+        for (int tag = TAG; tag < TAG + WORKERS * MESSAGES; ++tag) {
+            in.emplace_back(2);
+            receives.add(r.async(tag) >> in.back());
+        }
+    }
+
+    // Workers never call MPI, this thread drains the queue
+    mpi::SendQueue queue;
+    std::vector<std::vector<std::future<void>>> futures(WORKERS);
+    std::vector<std::thread> workers;
+    for (int w = 0; w < WORKERS; ++w) {
+        workers.emplace_back([&queue, &remote, &futures, rank, w] {
+            for (int m = 0; m < MESSAGES; ++m) {
+                for (const auto& r : *remote) {
+                    futures[static_cast<size_t>(w)].push_back(
+                        queue.push(r, mpi::array<int>({rank, w * MESSAGES + m}), TAG + w * MESSAGES + m));
+                }
+            }
+        });
+    }
+    while (!receives.test()) {
+        queue.poll();
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    queue.flush();
+    CHECK(queue.inflight() == 0);
+
+    for (auto& perWorker : futures) {
+        CHECK(perWorker.size() == remote->size() * MESSAGES);
+        for (auto& future : perWorker) {
+            CHECK(future.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+        }
+    }
+    size_t index = 0;
+    for (const auto& r : *remote) {
+        for (int i = 0; i < WORKERS * MESSAGES; ++i, ++index) {
+            CHECK(in[index][0] == r.rank());
+            CHECK(in[index][1] == i);
+        }
+    }
+}
+
+TEST_CASE("Aggregation") {
+    const auto local = mpi_env->getLocalProcess().lock();
+    const auto remote = mpi_env->getRemoteProcesses().lock();
+
+    CHECK(local);
+    CHECK(remote);
+
+    constexpr int N = 1000;
+    constexpr size_t CAPACITY = 256;
+    constexpr int TAG = 17;
+    const int rank = local->rank();
+
+    // Small messages stay below the eager limit, so sending everything first cannot block
+    for (auto& r : *remote) {
+        mpi::Aggregator out(r, TAG, CAPACITY);
+        for (int i = 0; i < N; ++i) {
+            out << rank + i;
+            if (i % 100 == 0) {
+                std::vector<double> pair = {0.5 * i, 1.5 * i};
+                out << mpi::array_view(pair) << static_cast<char>('a' + i % 26);
+            }
+        }
+        out << mpi::array<int>();
+        CHECK(out.messages() > 1);
+        CHECK(out.messages() < static_cast<size_t>(N) / 10);
+        out.flush();
+        CHECK(out.size() == 0);
+    }
+
+    for (auto& r : *remote) {
+        mpi::Disaggregator in(r, TAG);
+        for (int i = 0; i < N; ++i) {
+            int value;
+            in >> value;
+            CHECK(value == r.rank() + i);
+            if (i % 100 == 0) {
+                mpi::array<double> pair;
+                char c;
+                in >> pair >> c;
+                CHECK(pair.size() == 2);
+                CHECK(areEqual(pair[1], 1.5 * i));
+                CHECK(c == static_cast<char>('a' + i % 26));
+            }
+        }
+        mpi::array<int> none(3);
+        in >> none;
+        CHECK(none.size() == 0);
+        CHECK(in.empty());
+    }
+}
+
+TEST_CASE("Tracing") {
+    const auto local = mpi_env->getLocalProcess().lock();
+    const auto world = mpi_env->getWorld().lock();
+
+    CHECK(local);
+    CHECK(world);
+
+    mpi::trace::RingBuffer ring(4);
+    for (int i = 0; i < 10; ++i) {
+        ring.push({"op", i, i + 1, 0, -1, MPI_DATATYPE_NULL, 0});
+    }
+    CHECK(ring.size() == 4);
+    CHECK(ring.pushed() == 10);
+    CHECK(ring[0].begin == 6);
+    CHECK(ring[3].begin == 9);
+
+    // Tracing requested through the environment records until shutdown instead
+    if (mpi::trace::enabled()) {
+        return;
+    }
+
+    // Only rank 0 writes the merged trace
+    const std::string path = (std::filesystem::temp_directory_path() / "mpiwrapper_trace.json").string();
+
+    mpi::trace::start(world->get(), path);
+    CHECK(mpi::trace::enabled());
+    const mpi::array sum = mpi::allReduce<int>(*local + mpi::array<int>({1, 2, 3}));
+    const mpi::array all = mpi::iallGather<double>(local->forward(mpi::array<double>({0.5})))();
+    // Every thread records into a ring of its own
+    std::thread([] { const mpi::trace::Span span("worker", 0, -1, MPI_DATATYPE_NULL); }).join();
+    mpi::trace::finish(world->get());
+    CHECK(!mpi::trace::enabled());
+    CHECK(sum[2] == 3 * mpi_env->getCommSize());
+
+    if (local->rank() == 0) {
+        std::ifstream traceFile(path);
+        const std::string trace((std::istreambuf_iterator<char>(traceFile)), std::istreambuf_iterator<char>());
+        CHECK(trace.find("\"traceEvents\"") != std::string::npos);
+        CHECK(trace.find("\"name\": \"allReduce\"") != std::string::npos);
+        CHECK(trace.find("\"type\": \"MPI_INT\"") != std::string::npos);
+        CHECK(trace.find("\"name\": \"iallGather\"") != std::string::npos);
+        CHECK(trace.find("\"name\": \"wait\"") != std::string::npos);
+        CHECK(trace.find("\"name\": \"worker\"") != std::string::npos);
+
+        std::ifstream summaryFile(path + ".summary.txt");
+        const std::string summary((std::istreambuf_iterator<char>(summaryFile)), std::istreambuf_iterator<char>());
+        CHECK(summary.find("allReduce") != std::string::npos);
+        std::remove(path.c_str());
+        std::remove((path + ".summary.txt").c_str());
+    }
+}
+
+TEST_CASE("LargeCount") {
+    const auto local = mpi_env->getLocalProcess().lock();
+
+    CHECK(local);
+
+    // Counts beyond INT_MAX fold into one element of a derived type, no buffer involved
+    {
+        const mpi::LargeCount large(3'000'000'000, MPI_BYTE);
+        CHECK(large.count() == 1);
+        MPI_Count bytes;
+        MPI_Type_size_x(large.type(), &bytes);
+        CHECK(bytes == 3'000'000'000);
+    }
+    {
+        const mpi::LargeCount small(42, MPI_DOUBLE);
+        CHECK(small.count() == 42);
+        CHECK(small.type() == MPI_DOUBLE);
+    }
+    CHECK(mpi::checkedCount(7) == 7);
+    CHECK_THROWS_AS((void)mpi::checkedCount(size_t{1} << 31), std::overflow_error);
+
+    // Above pipelineThreshold broadcast and scatter go through segmented non-blocking collectives
+    const size_t size = mpi::pipelineThreshold / sizeof(int) + 12345;
+    mpi::array<int> data;
+    if (local->rank() == local->root()) {
+        data = mpi::array<int>(size);
+        std::iota(data.begin(), data.end(), 0);
+    }
+    const mpi::array received = mpi::broadcast<int>(local->bind(std::move(data), size));
+    CHECK(received.size() == size);
+    CHECK(received[0] == 0);
+    CHECK(received[size - 1] == static_cast<int>(size - 1));
+
+    const auto commSize = static_cast<size_t>(mpi_env->getCommSize());
+    mpi::array<int> all;
+    if (local->rank() == local->root()) {
+        all = mpi::array<int>(size * commSize);
+        std::iota(all.begin(), all.end(), 0);
+    }
+    const mpi::array chunk = mpi::scatter<int>(local->bind(std::move(all), size * commSize));
+    const auto first = static_cast<int>(size * static_cast<size_t>(local->rank()));
+    CHECK(chunk.size() == size);
+    CHECK(chunk[0] == first);
+    CHECK(chunk[size - 1] == first + static_cast<int>(size - 1));
+    bool ordered = true;
+    for (size_t i = 0; i < size; ++i) {
+        ordered = ordered && chunk[i] == first + static_cast<int>(i);
+    }
+    CHECK(ordered);
+}
+
+TEST_CASE("SampleSort") {
+    const auto local = mpi_env->getLocalProcess().lock();
+
+    CHECK(local);
+
+    const int rank = local->rank();
+    const auto commSize = static_cast<size_t>(mpi_env->getCommSize());
+
+    // Skewed input: rank r holds (r + 1) * 5000 values, few of them distinct
+    std::mt19937 gen(static_cast<unsigned>(rank) + 1);
+    std::uniform_int_distribution<int> dist(0, 999);
+    mpi::array<int> data(static_cast<size_t>(rank + 1) * 5000);
+    long sum = 0;
+    for (auto& value : data) {
+        value = dist(gen);
+        sum += value;
+    }
+
+    const mpi::array sorted = mpi::sort(local->forward(std::move(data)), std::greater<int>());
+    const mpi::array total = mpi::allReduce<long>(*local + mpi::array<long>({
+        static_cast<long>(sorted.size()), std::accumulate(sorted.begin(), sorted.end(), 0L)}));
+    const mpi::array expected = mpi::allReduce<long>(*local + mpi::array<long>({sum}));
+    CHECK(total[1] == expected[0]);
+    CHECK(sorted.size() == static_cast<size_t>(mpi::balancedCounts(static_cast<size_t>(total[0]), commSize)[
+        static_cast<size_t>(rank)]));
+    CHECK(std::is_sorted(sorted.data(), sorted.data() + sorted.size(), std::greater<int>()));
+
+    // Every block starts at or below where the previous one ended
+    const mpi::array bounds = mpi::allGather<int>(local->forward(mpi::array<int>({sorted[0], sorted[sorted.size() - 1]})));
+    for (size_t i = 1; i < commSize; ++i) {
+        CHECK(bounds[2 * i] <= bounds[2 * i - 1]);
+    }
+
+    // Non mpi types travel as bytes, ranks may start empty
+    struct Key {
+        int major;
+        int minor;
+    };
+    mpi::array<Key> keys(rank == 0 ? 0 : 300);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        keys[i] = {static_cast<int>(i % 7), rank};
+    }
+    const auto byMajor = [](const Key& a, const Key& b) {
+        return a.major < b.major || (a.major == b.major && a.minor < b.minor);
+    };
+    const mpi::array sortedKeys = mpi::sort(local->forward(std::move(keys)), byMajor, 2);
+    CHECK(std::is_sorted(sortedKeys.data(), sortedKeys.data() + sortedKeys.size(), byMajor));
+    CHECK(sortedKeys.size() == static_cast<size_t>(mpi::balancedCounts(300 * (commSize - 1), commSize)[
+        static_cast<size_t>(rank)]));
+}
+
+TEST_CASE("DistributedArray") {
+    const auto local = mpi_env->getLocalProcess().lock();
+
+    CHECK(local);
+
+    const int commSize = mpi_env->getCommSize();
+    const int rank = local->rank();
+
+    // Index maps agree with each other for both layouts, including a short last block
+    for (const auto& layout : {mpi::Layout::block(103, 4), mpi::Layout::blockCyclic(103, 4, 5)}) {
+        size_t held = 0;
+        bool consistent = true;
+        for (int r = 0; r < 4; ++r) {
+            for (size_t i = 0; i < layout.localSize(r); ++i) {
+                const size_t global = layout.global(r, i);
+                consistent = consistent && layout.owner(global) == r && layout.local(global) == i;
+            }
+            held += layout.localSize(r);
+        }
+        CHECK(consistent);
+        CHECK(held == 103);
+    }
+
+    constexpr size_t size = 1001;
+    mpi::DistributedArray<long> values(local, size);
+    values.for_each([](const size_t global, long& value) { value = static_cast<long>(global); });
+    CHECK(values.reduce() == static_cast<long>(size * (size - 1) / 2));
+    CHECK(values.localSize() == static_cast<size_t>(mpi::balancedCounts(size, static_cast<size_t>(commSize))[
+        static_cast<size_t>(rank)]));
+
+    const auto squares = values.transform([](const long value) { return static_cast<double>(value * value); });
+    CHECK(squares.layout() == values.layout());
+    CHECK(squares.reduce(0.0, [](const double a, const double b) { return std::max(a, b); })
+        == static_cast<double>((size - 1) * (size - 1)));
+
+    const auto cyclic = values.redistribute(mpi::Layout::blockCyclic(size, commSize, 7));
+    bool placed = true;
+    for (size_t i = 0; i < cyclic.localSize(); ++i) {
+        placed = placed && cyclic.local()[i] == static_cast<long>(cyclic.globalIndex(i));
+    }
+    CHECK(placed);
+    CHECK(cyclic.isLocal(7 * static_cast<size_t>(rank)));
+    CHECK(cyclic.at(7 * static_cast<size_t>(rank)) == 7 * rank);
+    CHECK_THROWS_AS((void)cyclic.at(size), std::out_of_range);
+
+    // Back through a different block size to the block layout
+    const auto back = cyclic.redistribute(mpi::Layout::blockCyclic(size, commSize, 3))
+        .redistribute(mpi::Layout::block(size, commSize));
+    bool restored = back.localSize() == values.localSize();
+    for (size_t i = 0; restored && i < back.localSize(); ++i) {
+        restored = back.local()[i] == values.local()[i];
+    }
+    CHECK(restored);
+    CHECK(back.reduce() == values.reduce());
+}
+
+TEST_CASE("HaloExchange") {
+    const auto world = mpi_env->getWorld().lock();
+
+    CHECK(world);
+
+    // Periodic rows, open columns
+    const mpi::Cartesian grid(*world, {0, 0}, {true, false});
+    CHECK(grid.dims()[0] * grid.dims()[1] == mpi_env->getCommSize());
+    CHECK(grid.rankAt(grid.coords()) == grid.rank());
+    CHECK(grid.rankAt({grid.coords()[0], grid.dims()[1]}) == MPI_PROC_NULL);
+    CHECK(grid.rankAt({grid.coords()[0] + grid.dims()[0], grid.coords()[1]}) == grid.rank());
+    const auto [below, above] = grid.shift(0);
+    CHECK(grid.coords(above)[0] == (grid.coords()[0] + 1) % grid.dims()[0]);
+    CHECK(grid.coords(below)[1] == grid.coords()[1]);
+    CHECK_THROWS_AS(mpi::Cartesian(*world, {mpi_env->getCommSize() + 1}), std::invalid_argument);
+
+    constexpr int rows = 6;
+    constexpr int cols = 5;
+    mpi::HaloExchange<int> halo(grid, {rows, cols}, 2);
+    const int x0 = grid.coords()[0] * rows;
+    const int y0 = grid.coords()[1] * cols;
+    const int height = grid.dims()[0] * rows;
+    const int width = grid.dims()[1] * cols;
+    const auto value = [](const int x, const int y) { return 1 + 1000 * x + y; };
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            halo(i, j) = value(x0 + i, y0 + j);
+        }
+    }
+
+    // Every owned cell is visited once, split between the overlapped and the late part
+    std::vector<int> visits(halo.data().size(), 0);
+    halo.start();
+    CHECK_THROWS_AS(halo.start(), std::logic_error);
+    halo.forEachInterior([&](const size_t offset) { ++visits[offset]; });
+    halo.wait();
+    halo.forEachBoundary([&](const size_t offset) { ++visits[offset]; });
+    CHECK(std::count(visits.begin(), visits.end(), 1) == rows * cols);
+    CHECK(std::count(visits.begin(), visits.end(), 0) == static_cast<long>(halo.data().size()) - rows * cols);
+    CHECK(halo.stride(0) == static_cast<size_t>(cols + 4));
+
+    bool rowGhosts = true;
+    for (int j = 0; j < cols; ++j) {
+        for (int k = 1; k <= 2; ++k) {
+            rowGhosts = rowGhosts && halo(-k, j) == value((x0 - k + height) % height, y0 + j);
+            rowGhosts = rowGhosts && halo(rows - 1 + k, j) == value((x0 + rows - 1 + k) % height, y0 + j);
+        }
+    }
+    CHECK(rowGhosts);
+
+    bool colGhosts = true;
+    for (int i = 0; i < rows; ++i) {
+        for (int k = 1; k <= 2; ++k) {
+            const int left = y0 - k;
+            const int right = y0 + cols - 1 + k;
+            colGhosts = colGhosts && halo(i, -k) == (left < 0 ? 0 : value(x0 + i, left));
+            colGhosts = colGhosts && halo(i, cols - 1 + k) == (right >= width ? 0 : value(x0 + i, right));
+        }
+    }
+    CHECK(colGhosts);
+
+    // Persistent requests are reused by the next exchange
+    halo(0, 0) = -1;
+    halo.exchange();
+    if (grid.dims()[0] == 1) {
+        CHECK(halo(rows, 0) == -1);
+    }
+}
+
+TEST_CASE("NeighborCollectives") {
+    const auto world = mpi_env->getWorld().lock();
+
+    CHECK(world);
+
+    const int commSize = mpi_env->getCommSize();
+    const int left = (world->rank() + commSize - 1) % commSize;
+    const int right = (world->rank() + 1) % commSize;
+
+    // Ring, ranks may be renumbered by the library
+    const mpi::DistGraph ring(*world, {left, right});
+    CHECK(ring.indegree() == 2);
+    CHECK(ring.outdegree() == 2);
+    const mpi::LocalProcess node(ring.communicator());
+
+    const mpi::array gathered = mpi::neighborAllGather<int>(node.forward(mpi::array<int>({ring.rank()})));
+    CHECK(gathered.size() == 2);
+    CHECK(gathered[0] == ring.sources()[0]);
+    CHECK(gathered[1] == ring.sources()[1]);
+
+    // Block i goes to destination i
+    mpi::array<int> blocks(4);
+    for (int i = 0; i < 2; ++i) {
+        blocks[static_cast<size_t>(2 * i)] = ring.rank();
+        blocks[static_cast<size_t>(2 * i + 1)] = ring.destinations()[static_cast<size_t>(i)];
+    }
+    const mpi::array exchanged = mpi::neighborAllToAll<int>(node.forward(std::move(blocks)));
+    CHECK(exchanged.size() == 4);
+    bool addressed = true;
+    for (size_t j = 0; j < 2; ++j) {
+        addressed = addressed && exchanged[2 * j] == ring.sources()[j] && exchanged[2 * j + 1] == ring.rank();
+    }
+    CHECK(addressed);
+
+    // Destination i gets i + 1 copies of the rank
+    mpi::array<int> copies({ring.rank(), ring.rank(), ring.rank()});
+    const mpi::array varied = mpi::neighborAllToAllv<int>(node.forward(std::move(copies)), mpi::array<int>({1, 2}));
+    CHECK(varied.size() == 3);
+    CHECK(std::all_of(varied.begin(), varied.end(), [&](const int value) {
+        return value == ring.sources()[0] || value == ring.sources()[1];
+    }));
+    CHECK_THROWS_AS((void)mpi::neighborAllToAllv<int>(node.forward(mpi::array<int>(2)), mpi::array<int>({1})),
+                    std::invalid_argument);
+
+    // Byte path over a weighted, directed graph: receive from the left, send to the right
+    struct Pair {
+        int from;
+        double weight;
+    };
+    const mpi::DistGraph flow(*world, {left}, {right}, {1}, {1});
+    const mpi::LocalProcess downstream(flow.communicator());
+    const mpi::array pairs = mpi::neighborAllGather<Pair>(
+        downstream.forward(mpi::array<Pair>({{flow.rank(), 0.5}})));
+    CHECK(pairs.size() == 1);
+    CHECK(pairs[0].from == flow.sources()[0]);
+
+    // Cartesian grids are topologies too, with both shift neighbours per dimension
+    const mpi::Cartesian line(*world, {commSize}, {true});
+    const mpi::LocalProcess cell(line.communicator());
+    const mpi::array around = mpi::neighborAllGather<int>(cell.forward(mpi::array<int>({line.rank()})));
+    const auto [below, above] = line.shift(0);
+    CHECK(around.size() == 2);
+    CHECK(around[0] == below);
+    CHECK(around[1] == above);
+
+    CHECK_THROWS_AS((void)mpi::neighborDegrees(world->get()), std::invalid_argument);
+}
+
+TEST_CASE("TransformReduce") {
+    const auto local = mpi_env->getLocalProcess().lock();
+
+    CHECK(local);
+
+    const int commSize = mpi_env->getCommSize();
+    const int rank = local->rank();
+    constexpr size_t size = 1003;
+
+    mpi::array<int> chunk(size);
+    std::iota(chunk.begin(), chunk.end(), 0);
+
+    // Element-wise, evaluated into the send buffer
+    const mpi::array squares = mpi::allReduce(*local + mpi::transform(mpi::array<int>(chunk),
+        [](const int x) { return static_cast<double>(x) * x; }));
+    CHECK(squares.size() == size);
+    CHECK(squares[10] == 100.0 * commSize);
+
+    // Nested transforms fuse into one function per element, the type may change along the way
+    const long doubled = mpi::transformAllReduce(*local + mpi::transform(
+        mpi::transform(mpi::array<int>(chunk), [rank](const int x) { return x + rank; }),
+        [](const int x) { return static_cast<long>(x) * 2; }));
+    const mpi::array prefix = mpi::scan(*local + mpi::transform(mpi::array<int>(chunk),
+        [rank](const int x) { return x + rank; }));
+    CHECK(prefix[3] == 3 * (rank + 1) + rank * (rank + 1) / 2);
+
+    // Scalar reductions only move one value, ranks may hold nothing
+    mpi::array<int> part(rank == 0 ? 0 : size);
+    std::iota(part.begin(), part.end(), 0);
+    const long sumOfSquares = mpi::transformAllReduce(*local + mpi::transform(std::move(part),
+        [](const int x) { return static_cast<long>(x) * x; }));
+    const long perRank = static_cast<long>((size - 1) * size * (2 * size - 1) / 6);
+    CHECK(sumOfSquares == perRank * (commSize - 1));
+
+    const long ranks = static_cast<long>(commSize) * (commSize - 1) / 2;
+    CHECK(doubled == 2 * (static_cast<long>(size * (size - 1) / 2) * commSize + static_cast<long>(size) * ranks));
+
+    const double largest = mpi::transformReduce(local->max(mpi::transform(mpi::array<int>(chunk),
+        [rank](const int x) { return static_cast<double>(x - rank); })));
+    if (rank == local->root()) {
+        CHECK(largest == static_cast<double>(size - 1));
+    }
+    const int smallest = mpi::transformAllReduce(local->min(mpi::transform(mpi::array<int>(chunk),
+        [rank](const int x) { return x - rank; })));
+    CHECK(smallest == 1 - commSize);
+    const int parity = mpi::transformAllReduce(*local ^ mpi::transform(mpi::array<int>({rank}),
+        [](const int x) { return x & 1; }));
+    CHECK(parity == (commSize / 2) % 2);
+}
+
 TEST_CASE("GaussianElimination") {
 
     const std::vector solution = {
@@ -265,7 +1648,7 @@ TEST_CASE("GaussianElimination") {
         (~*local)([&remote, &chunk, rowsPerProcess, k, mappedProcess, &local] {
             const mpi::array<double> pivotRow(M);
             const auto it = std::ranges::find_if(*remote,
-            [](const mpi::RemoteProcess& r){ return r.rank() == mpi::LocalProcess::ROOT; });
+            [&local](const mpi::RemoteProcess& r){ return r.rank() == local->root(); });
 
             if (local->rank() > mappedProcess) {
                 it->sync() >> pivotRow;